@@ -0,0 +1,253 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <emmintrin.h>
+#include <SDL.h>
+#include "worldRect.h"
+
+// batched versions of the collision tests and transforms, one rect against many at a time
+// the many are stored as separate coordinate arrays so every test runs on whole SSE2 registers,
+// int32 lanes for fixed point and float lanes with WORLD_FLOAT_COORDS
+// results match the one-rect-at-a-time functions exactly, 2dRpg -bench checks that
+
+const int WorldRectLanes = 4;
+
+#ifdef WORLD_FLOAT_COORDS
+typedef __m128 WorldLanes;
+
+inline WorldLanes loadWorldLanes(const WorldCoord *p) { return _mm_load_ps(p); }
+inline WorldLanes setWorldLanes(WorldCoord value) { return _mm_set1_ps(value); }
+inline WorldLanes addWorldLanes(WorldLanes a, WorldLanes b) { return _mm_add_ps(a, b); }
+inline int lessMask(WorldLanes a, WorldLanes b) { return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+inline int equalMask(WorldLanes a, WorldLanes b) { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)); }
+#else
+typedef __m128i WorldLanes;
+
+inline WorldLanes loadWorldLanes(const WorldCoord *p) { return _mm_load_si128((const __m128i *)p); }
+inline WorldLanes setWorldLanes(WorldCoord value) { return _mm_set1_epi32(value); }
+inline WorldLanes addWorldLanes(WorldLanes a, WorldLanes b) { return _mm_add_epi32(a, b); }
+inline int lessMask(WorldLanes a, WorldLanes b) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(a, b))); }
+inline int equalMask(WorldLanes a, WorldLanes b) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b))); }
+#endif
+
+// lane results as one byte per rect, 1 where the test holds
+const uint8_t LaneMaskBytes[16][4] = {
+	{0,0,0,0}, {1,0,0,0}, {0,1,0,0}, {1,1,0,0}, {0,0,1,0}, {1,0,1,0}, {0,1,1,0}, {1,1,1,0},
+	{0,0,0,1}, {1,0,0,1}, {0,1,0,1}, {1,1,0,1}, {0,0,1,1}, {1,0,1,1}, {0,1,1,1}, {1,1,1,1}
+};
+
+struct WorldRectArrays {
+	int capacity = 0;   // whole lanes
+	int count = 0;
+	WorldCoord *memory = NULL;
+	WorldCoord *x = NULL;
+	WorldCoord *y = NULL;
+	WorldCoord *w = NULL;
+	WorldCoord *h = NULL;
+};
+
+// the padding past count is zeroed so the last partial register compares harmless values
+inline bool initWorldRectArrays(WorldRectArrays &rects, int count) {
+	int capacity = (count + WorldRectLanes - 1) / WorldRectLanes * WorldRectLanes;
+	rects.memory = (WorldCoord *)_mm_malloc(4 * capacity * sizeof(WorldCoord), 16);
+	if(rects.memory == NULL) {
+		return false;
+	}
+	memset(rects.memory, 0, 4 * capacity * sizeof(WorldCoord));
+	rects.capacity = capacity;
+	rects.count = count;
+	rects.x = rects.memory;
+	rects.y = rects.x + capacity;
+	rects.w = rects.y + capacity;
+	rects.h = rects.w + capacity;
+	return true;
+}
+
+inline void freeWorldRectArrays(WorldRectArrays &rects) {
+	_mm_free(rects.memory);
+	rects.memory = rects.x = rects.y = rects.w = rects.h = NULL;
+	rects.capacity = rects.count = 0;
+}
+
+inline void setWorldRect(WorldRectArrays &rects, int i, const WorldRect &rect) {
+	rects.x[i] = rect.x;
+	rects.y[i] = rect.y;
+	rects.w[i] = rect.w;
+	rects.h[i] = rect.h;
+}
+
+// out needs room for capacity bytes, the padding lanes get written too
+inline void storeLaneMask(uint8_t *out, int mask) {
+	memcpy(out, LaneMaskBytes[mask], 4);
+}
+
+// xOverlap(a, b[i]) for every b
+inline void xOverlapMany(WorldRect &a, WorldRectArrays &b, uint8_t *out) {
+	WorldLanes left = setWorldLanes(a.x);
+	WorldLanes right = setWorldLanes(a.x + a.w);
+	for(int i = 0; i < b.count; i += WorldRectLanes) {
+		WorldLanes bx = loadWorldLanes(b.x + i);
+		WorldLanes bRight = addWorldLanes(bx, loadWorldLanes(b.w + i));
+		storeLaneMask(out + i, lessMask(bx, right) & lessMask(left, bRight));
+	}
+}
+
+inline void yOverlapMany(WorldRect &a, WorldRectArrays &b, uint8_t *out) {
+	WorldLanes bottom = setWorldLanes(a.y);
+	WorldLanes top = setWorldLanes(a.y + a.h);
+	for(int i = 0; i < b.count; i += WorldRectLanes) {
+		WorldLanes by = loadWorldLanes(b.y + i);
+		WorldLanes bTop = addWorldLanes(by, loadWorldLanes(b.h + i));
+		storeLaneMask(out + i, lessMask(by, top) & lessMask(bottom, bTop));
+	}
+}
+
+inline void standingOnMany(WorldRect &a, WorldRectArrays &b, uint8_t *out) {
+	WorldLanes bottom = setWorldLanes(a.y);
+	for(int i = 0; i < b.count; i += WorldRectLanes) {
+		WorldLanes bTop = addWorldLanes(loadWorldLanes(b.y + i), loadWorldLanes(b.h + i));
+		storeLaneMask(out + i, equalMask(bottom, bTop));
+	}
+}
+
+inline void isAboveMany(WorldRect &a, WorldRectArrays &b, uint8_t *out) {
+	WorldLanes bottom = setWorldLanes(a.y);
+	for(int i = 0; i < b.count; i += WorldRectLanes) {
+		WorldLanes bTop = addWorldLanes(loadWorldLanes(b.y + i), loadWorldLanes(b.h + i));
+		storeLaneMask(out + i, lessMask(bottom, bTop) ^ 0xF);
+	}
+}
+
+inline void isBelowTopMany(WorldRect &a, WorldRectArrays &b, uint8_t *out) {
+	WorldLanes bottom = setWorldLanes(a.y);
+	for(int i = 0; i < b.count; i += WorldRectLanes) {
+		WorldLanes bTop = addWorldLanes(loadWorldLanes(b.y + i), loadWorldLanes(b.h + i));
+		storeLaneMask(out + i, lessMask(bottom, bTop));
+	}
+}
+
+// meters as floats, the same two roundings toMeters and the pixel scale do one at a time
+inline __m128 worldLanesToMeters(WorldLanes lanes) {
+#ifdef WORLD_FLOAT_COORDS
+	return lanes;
+#else
+	return _mm_mul_ps(_mm_cvtepi32_ps(lanes), _mm_set1_ps(1.0f / WorldUnitsPerMeter));
+#endif
+}
+
+// worldRectToRenderRect for every rect, out needs room for capacity rects
+inline void worldRectsToRenderRects(WorldRectArrays &rects, SDL_Rect *out,
+	float pixPerHorizontalMeter, float pixPerVerticalMeter, int screenHeight) {
+	__m128 scaleX = _mm_set1_ps(pixPerHorizontalMeter);
+	__m128 scaleY = _mm_set1_ps(pixPerVerticalMeter);
+	__m128i height = _mm_set1_epi32(screenHeight);
+	for(int i = 0; i < rects.count; i += WorldRectLanes) {
+		__m128i x = _mm_cvttps_epi32(_mm_mul_ps(worldLanesToMeters(loadWorldLanes(rects.x + i)), scaleX));
+		__m128i y = _mm_cvttps_epi32(_mm_mul_ps(worldLanesToMeters(loadWorldLanes(rects.y + i)), scaleY));
+		__m128i w = _mm_cvttps_epi32(_mm_mul_ps(worldLanesToMeters(loadWorldLanes(rects.w + i)), scaleX));
+		__m128i h = _mm_cvttps_epi32(_mm_mul_ps(worldLanesToMeters(loadWorldLanes(rects.h + i)), scaleY));
+		y = _mm_sub_epi32(height, _mm_add_epi32(y, h));
+
+		// x,y,w,h columns to one SDL_Rect per lane
+		__m128i xy01 = _mm_unpacklo_epi32(x, y);
+		__m128i xy23 = _mm_unpackhi_epi32(x, y);
+		__m128i wh01 = _mm_unpacklo_epi32(w, h);
+		__m128i wh23 = _mm_unpackhi_epi32(w, h);
+		_mm_storeu_si128((__m128i *)&out[i + 0], _mm_unpacklo_epi64(xy01, wh01));
+		_mm_storeu_si128((__m128i *)&out[i + 1], _mm_unpackhi_epi64(xy01, wh01));
+		_mm_storeu_si128((__m128i *)&out[i + 2], _mm_unpacklo_epi64(xy23, wh23));
+		_mm_storeu_si128((__m128i *)&out[i + 3], _mm_unpackhi_epi64(xy23, wh23));
+	}
+}
+
+// SSE2 has no 32-bit min/max, pick with a compare mask instead
+inline __m128i selectLanes(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+inline __m128i minLanes(__m128i a, __m128i b) {
+	return selectLanes(_mm_cmplt_epi32(a, b), a, b);
+}
+
+inline __m128i maxLanes(__m128i a, __m128i b) {
+	return selectLanes(_mm_cmpgt_epi32(a, b), a, b);
+}
+
+// clamp for count ints, in and out need room for count rounded up to whole lanes
+// min can't be above max, clamp and this disagree there
+inline void clampMany(const int *in, int *out, int count, int min, int max) {
+	__m128i low = _mm_set1_epi32(min);
+	__m128i high = _mm_set1_epi32(max);
+	for(int i = 0; i < count; i += 4) {
+		__m128i values = _mm_loadu_si128((const __m128i *)(in + i));
+		_mm_storeu_si128((__m128i *)(out + i), minLanes(maxLanes(values, low), high));
+	}
+}
+
+// whole tiles a coordinate is into the map, truncated like int division
+#ifdef WORLD_FLOAT_COORDS
+inline __m128i tileLanes(WorldLanes coords, WorldCoord tileSize) {
+	return _mm_cvttps_epi32(_mm_div_ps(coords, _mm_set1_ps(tileSize)));
+}
+#else
+// double division is exact enough that truncating it always agrees with int division, two lanes at a time
+inline __m128i tileLanes(WorldLanes coords, WorldCoord tileSize) {
+	__m128d size = _mm_set1_pd(tileSize);
+	__m128i low = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(coords), size));
+	__m128i high = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(coords, _MM_SHUFFLE(1, 0, 3, 2))), size));
+	return _mm_unpacklo_epi64(low, high);
+}
+#endif
+
+// collisionWindow for every rect, the tile windows come out as four arrays with room for capacity ints
+inline void collisionWindowMany(WorldRectArrays &rects, WorldCoord tileWorldWidth, WorldCoord tileWorldHeight,
+	int mapWidth, int mapHeight, int *minTileX, int *minTileY, int *maxTileX, int *maxTileY) {
+	__m128i zero = _mm_setzero_si128();
+	__m128i one = _mm_set1_epi32(1);
+	__m128i two = _mm_set1_epi32(2);
+	__m128i width = _mm_set1_epi32(mapWidth);
+	__m128i height = _mm_set1_epi32(mapHeight);
+	for(int i = 0; i < rects.count; i += WorldRectLanes) {
+		WorldLanes x = loadWorldLanes(rects.x + i);
+		WorldLanes y = loadWorldLanes(rects.y + i);
+		__m128i minX = _mm_sub_epi32(tileLanes(x, tileWorldWidth), one);
+		__m128i maxX = _mm_add_epi32(tileLanes(addWorldLanes(x, loadWorldLanes(rects.w + i)), tileWorldWidth), two);
+		__m128i minY = _mm_sub_epi32(tileLanes(y, tileWorldHeight), one);
+		__m128i maxY = _mm_add_epi32(tileLanes(addWorldLanes(y, loadWorldLanes(rects.h + i)), tileWorldHeight), two);
+		_mm_storeu_si128((__m128i *)(minTileX + i), maxLanes(minX, zero));
+		_mm_storeu_si128((__m128i *)(minTileY + i), maxLanes(minY, zero));
+		_mm_storeu_si128((__m128i *)(maxTileX + i), minLanes(maxX, width));
+		_mm_storeu_si128((__m128i *)(maxTileY + i), minLanes(maxY, height));
+	}
+}
+
+// OccupiedTiles with the tiles packed into one int each, so add looks through a register of them per compare
+// empty slots hold -1, the key of tile (65535, 65535), which a level never has: they are at most 65535 tiles
+// on a side (levelFormat.h), so x and y stay below 65535
+struct OccupiedTileKeys {
+	static const int MaxNumOccupiedTiles = 20;
+	int32_t keys[MaxNumOccupiedTiles];
+	int numOccupiedTiles;
+};
+
+inline int32_t occupiedTileKey(int x, int y) {
+	SDL_assert(x >= 0 && x < 0xFFFF && y >= 0 && y < 0xFFFF);
+	return (int32_t)((uint32_t)y << 16 | (uint32_t)(x & 0xFFFF));
+}
+
+inline void clearOccupiedTileKeys(OccupiedTileKeys &tiles) {
+	memset(tiles.keys, 0xFF, sizeof(tiles.keys));
+	tiles.numOccupiedTiles = 0;
+}
+
+inline void addOccupiedTileKey(OccupiedTileKeys &tiles, int x, int y) {
+	int32_t key = occupiedTileKey(x, y);
+	__m128i keyLanes = _mm_set1_epi32(key);
+	int found = 0;
+	for(int i = 0; i < OccupiedTileKeys::MaxNumOccupiedTiles; i += 4) {
+		found |= _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(tiles.keys + i)), keyLanes));
+	}
+	if(!found && tiles.numOccupiedTiles < OccupiedTileKeys::MaxNumOccupiedTiles) {
+		tiles.keys[tiles.numOccupiedTiles++] = key;
+	}
+}
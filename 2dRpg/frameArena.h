@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <SDL.h>
+
+// bump allocator for memory that only lives until the end of the frame
+// one block is allocated up front, allocating moves a pointer and resetArena frees everything at once
+
+struct FrameArena {
+	uint8_t *memory = NULL;
+	size_t capacity = 0;
+	size_t used = 0;
+	size_t peak = 0;     // most used in any frame
+	int numFailed = 0;   // allocations that didn't fit since the last reset
+};
+
+inline bool initArena(FrameArena &arena, size_t capacity) {
+	arena.memory = (uint8_t *)malloc(capacity);
+	if(arena.memory == NULL) {
+		return false;
+	}
+	arena.capacity = capacity;
+	arena.used = 0;
+	arena.peak = 0;
+	arena.numFailed = 0;
+	return true;
+}
+
+inline void freeArena(FrameArena &arena) {
+	free(arena.memory);
+	arena = FrameArena();
+}
+
+inline void resetArena(FrameArena &arena) {
+	arena.used = 0;
+	arena.numFailed = 0;
+}
+
+// returns NULL when the arena is full, alignment has to be a power of two
+inline void *arenaAlloc(FrameArena &arena, size_t size, size_t alignment = 8) {
+	size_t begin = (arena.used + alignment - 1) & ~(alignment - 1);
+	if(begin + size > arena.capacity) {
+		arena.numFailed++;
+		return NULL;
+	}
+	arena.used = begin + size;
+	arena.peak = (arena.used > arena.peak) ? arena.used : arena.peak;
+	return arena.memory + begin;
+}
+
+template<typename T>
+T *arenaAllocArray(FrameArena &arena, int count) {
+	return (T *)arenaAlloc(arena, sizeof(T) * count, __alignof(T));
+}
+
+// formats into the arena, returns NULL when it doesn't fit
+inline char *arenaVprintf(FrameArena &arena, const char *fmt, va_list argList) {
+	char *text = (char *)(arena.memory + arena.used);
+	size_t space = arena.capacity - arena.used;
+	int length = SDL_vsnprintf(text, space, fmt, argList);
+	if(length < 0 || (size_t)length >= space) {
+		arena.numFailed++;
+		return NULL;
+	}
+	return (char *)arenaAlloc(arena, length + 1, 1);
+}
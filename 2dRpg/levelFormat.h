@@ -0,0 +1,264 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Compiled level file, shared by the game and mapCompiler.
+// Everything is little-endian and every section starts on a 4 byte boundary,
+// so the game can map the file and point straight into it.
+//
+//   LevelHeader
+//   uint8_t    tiles[height][width]   TileType per tile, row 0 is the bottom row
+//   LevelChunk chunks[chunksY][chunksX]
+//   LevelQuad  quads[numQuads]        tile graphics, grouped by chunk
+//   LevelRow   rows[height]
+//   LevelSpan  spans[numSpans]        runs of equal, non-empty tiles per row
+
+enum TileType {
+	TileNone = 0,
+	TilePlatform = 1,
+	TileLadder = 2,
+	TileNumElements
+};
+
+const uint32_t LevelMagic = 0x4C564C32; // "2LVL"
+const uint32_t LevelVersion = 1;
+const uint16_t LevelNoGraphic = 0xFFFF;
+
+struct LevelHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t fileSize;
+	uint16_t width;          // tiles
+	uint16_t height;         // tiles
+	uint16_t chunkSize;      // tiles per chunk side
+	uint16_t chunksX;
+	uint16_t chunksY;
+	uint16_t tilePixels;     // size of one tile in the tileset and in the baked map
+	uint32_t tilesOffset;
+	uint32_t chunksOffset;
+	uint32_t quadsOffset;
+	uint32_t rowsOffset;
+	uint32_t spansOffset;
+	uint32_t numQuads;
+	uint32_t numSpans;
+};
+
+// pixel origin of the chunk in the baked map image (top-left origin)
+struct LevelChunk {
+	uint32_t pixelX;
+	uint32_t pixelY;
+	uint32_t firstQuad;
+	uint32_t numQuads;
+};
+
+// one tile graphic, source is in the tileset, dest is relative to the chunk origin
+struct LevelQuad {
+	uint16_t sourceX;
+	uint16_t sourceY;
+	uint16_t destX;
+	uint16_t destY;
+};
+
+struct LevelRow {
+	uint32_t firstSpan;
+	uint32_t numSpans;
+};
+
+// tiles [xBegin, xEnd) of a row all have this type
+struct LevelSpan {
+	uint16_t xBegin;
+	uint16_t xEnd;
+	uint32_t type;
+};
+
+// uncompiled level, as read from a map file or generated
+struct LevelSource {
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> types;                 // TileType, [y*width + x], row 0 is the bottom row
+	std::vector<std::vector<uint16_t>> layers;  // tileset index per tile, or LevelNoGraphic
+};
+
+inline uint32_t levelAlign(uint32_t offset) {
+	return (offset + 3) & ~3u;
+}
+
+inline void levelPut16(std::vector<uint8_t> &out, uint32_t offset, uint16_t value) {
+	out[offset + 0] = (uint8_t)(value);
+	out[offset + 1] = (uint8_t)(value >> 8);
+}
+
+inline void levelPut32(std::vector<uint8_t> &out, uint32_t offset, uint32_t value) {
+	out[offset + 0] = (uint8_t)(value);
+	out[offset + 1] = (uint8_t)(value >> 8);
+	out[offset + 2] = (uint8_t)(value >> 16);
+	out[offset + 3] = (uint8_t)(value >> 24);
+}
+
+// serializes a level source into the compiled format
+// fields are written byte by byte, so the output is little-endian on any host
+// the caller keeps the sizes inside the format: width and height fit in 16 bits, a chunk's pixels
+// (chunkSize*tilePixels) fit in a quad's 16 bit dest, and width*height leaves the 32 bit offsets room
+inline std::vector<uint8_t> buildLevel(LevelSource &src, int chunkSize, int tilePixels, int tilesetColumns) {
+	int chunksX = (src.width + chunkSize - 1) / chunkSize;
+	int chunksY = (src.height + chunkSize - 1) / chunkSize;
+
+	// collision spans
+	std::vector<LevelRow> rows(src.height);
+	std::vector<LevelSpan> spans;
+	for(int y = 0; y < src.height; y++) {
+		rows[y].firstSpan = (uint32_t)spans.size();
+		int x = 0;
+		while(x < src.width) {
+			uint8_t type = src.types[y*src.width + x];
+			int end = x + 1;
+			while(end < src.width && src.types[y*src.width + end] == type) {
+				end++;
+			}
+			if(type != TileNone) {
+				LevelSpan span = {(uint16_t)x, (uint16_t)end, type};
+				spans.push_back(span);
+			}
+			x = end;
+		}
+		rows[y].numSpans = (uint32_t)spans.size() - rows[y].firstSpan;
+	}
+
+	// render data, chunk by chunk, layer by layer
+	std::vector<LevelChunk> chunks(chunksX * chunksY);
+	std::vector<LevelQuad> quads;
+	for(int cy = 0; cy < chunksY; cy++) {
+		for(int cx = 0; cx < chunksX; cx++) {
+			LevelChunk &chunk = chunks[cy*chunksX + cx];
+			int chunkTop = (cy + 1)*chunkSize < src.height ? (cy + 1)*chunkSize : src.height;
+			chunk.pixelX = (uint32_t)(cx*chunkSize*tilePixels);
+			chunk.pixelY = (uint32_t)((src.height - chunkTop)*tilePixels);
+			chunk.firstQuad = (uint32_t)quads.size();
+			for(size_t layer = 0; layer < src.layers.size(); layer++) {
+				for(int y = cy*chunkSize; y < chunkTop; y++) {
+					for(int x = cx*chunkSize; x < (cx + 1)*chunkSize && x < src.width; x++) {
+						uint16_t graphic = src.layers[layer][y*src.width + x];
+						if(graphic == LevelNoGraphic) {
+							continue;
+						}
+						LevelQuad quad;
+						quad.sourceX = (uint16_t)((graphic % tilesetColumns) * tilePixels);
+						quad.sourceY = (uint16_t)((graphic / tilesetColumns) * tilePixels);
+						quad.destX = (uint16_t)((x - cx*chunkSize) * tilePixels);
+						quad.destY = (uint16_t)(((chunkTop - 1) - y) * tilePixels);
+						quads.push_back(quad);
+					}
+				}
+			}
+			chunk.numQuads = (uint32_t)quads.size() - chunk.firstQuad;
+		}
+	}
+
+	uint32_t tilesOffset = levelAlign(sizeof(LevelHeader));
+	uint32_t chunksOffset = levelAlign(tilesOffset + src.width*src.height);
+	uint32_t quadsOffset = levelAlign(chunksOffset + (uint32_t)(chunks.size() * sizeof(LevelChunk)));
+	uint32_t rowsOffset = levelAlign(quadsOffset + (uint32_t)(quads.size() * sizeof(LevelQuad)));
+	uint32_t spansOffset = levelAlign(rowsOffset + (uint32_t)(rows.size() * sizeof(LevelRow)));
+	uint32_t fileSize = spansOffset + (uint32_t)(spans.size() * sizeof(LevelSpan));
+
+	std::vector<uint8_t> out(fileSize, 0);
+	levelPut32(out, offsetof(LevelHeader, magic), LevelMagic);
+	levelPut32(out, offsetof(LevelHeader, version), LevelVersion);
+	levelPut32(out, offsetof(LevelHeader, fileSize), fileSize);
+	levelPut16(out, offsetof(LevelHeader, width), (uint16_t)src.width);
+	levelPut16(out, offsetof(LevelHeader, height), (uint16_t)src.height);
+	levelPut16(out, offsetof(LevelHeader, chunkSize), (uint16_t)chunkSize);
+	levelPut16(out, offsetof(LevelHeader, chunksX), (uint16_t)chunksX);
+	levelPut16(out, offsetof(LevelHeader, chunksY), (uint16_t)chunksY);
+	levelPut16(out, offsetof(LevelHeader, tilePixels), (uint16_t)tilePixels);
+	levelPut32(out, offsetof(LevelHeader, tilesOffset), tilesOffset);
+	levelPut32(out, offsetof(LevelHeader, chunksOffset), chunksOffset);
+	levelPut32(out, offsetof(LevelHeader, quadsOffset), quadsOffset);
+	levelPut32(out, offsetof(LevelHeader, rowsOffset), rowsOffset);
+	levelPut32(out, offsetof(LevelHeader, spansOffset), spansOffset);
+	levelPut32(out, offsetof(LevelHeader, numQuads), (uint32_t)quads.size());
+	levelPut32(out, offsetof(LevelHeader, numSpans), (uint32_t)spans.size());
+
+	for(int i = 0; i < src.width*src.height; i++) {
+		out[tilesOffset + i] = src.types[i];
+	}
+	for(size_t i = 0; i < chunks.size(); i++) {
+		uint32_t at = chunksOffset + (uint32_t)(i * sizeof(LevelChunk));
+		levelPut32(out, at + offsetof(LevelChunk, pixelX), chunks[i].pixelX);
+		levelPut32(out, at + offsetof(LevelChunk, pixelY), chunks[i].pixelY);
+		levelPut32(out, at + offsetof(LevelChunk, firstQuad), chunks[i].firstQuad);
+		levelPut32(out, at + offsetof(LevelChunk, numQuads), chunks[i].numQuads);
+	}
+	for(size_t i = 0; i < quads.size(); i++) {
+		uint32_t at = quadsOffset + (uint32_t)(i * sizeof(LevelQuad));
+		levelPut16(out, at + offsetof(LevelQuad, sourceX), quads[i].sourceX);
+		levelPut16(out, at + offsetof(LevelQuad, sourceY), quads[i].sourceY);
+		levelPut16(out, at + offsetof(LevelQuad, destX), quads[i].destX);
+		levelPut16(out, at + offsetof(LevelQuad, destY), quads[i].destY);
+	}
+	for(size_t i = 0; i < rows.size(); i++) {
+		uint32_t at = rowsOffset + (uint32_t)(i * sizeof(LevelRow));
+		levelPut32(out, at + offsetof(LevelRow, firstSpan), rows[i].firstSpan);
+		levelPut32(out, at + offsetof(LevelRow, numSpans), rows[i].numSpans);
+	}
+	for(size_t i = 0; i < spans.size(); i++) {
+		uint32_t at = spansOffset + (uint32_t)(i * sizeof(LevelSpan));
+		levelPut16(out, at + offsetof(LevelSpan, xBegin), spans[i].xBegin);
+		levelPut16(out, at + offsetof(LevelSpan, xEnd), spans[i].xEnd);
+		levelPut32(out, at + offsetof(LevelSpan, type), spans[i].type);
+	}
+	return out;
+}
+
+inline bool levelSectionFits(uint32_t offset, uint32_t count, uint32_t elementSize, uint32_t fileSize) {
+	return (offset & 3) == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+// checks a compiled level in place, returns its header or NULL
+// the level is used without conversion, so a big-endian host is rejected too
+inline const LevelHeader *validateLevel(const void *data, size_t size) {
+	uint32_t one = 1;
+	if(*(const uint8_t *)&one != 1 || data == NULL || size < sizeof(LevelHeader) || ((uintptr_t)data & 3) != 0) {
+		return NULL;
+	}
+
+	const LevelHeader *header = (const LevelHeader *)data;
+	if(header->magic != LevelMagic || header->version != LevelVersion || header->fileSize != size ||
+		header->width == 0 || header->height == 0 || header->chunkSize == 0 || header->tilePixels == 0 ||
+		header->chunksX != (header->width + header->chunkSize - 1) / header->chunkSize ||
+		header->chunksY != (header->height + header->chunkSize - 1) / header->chunkSize) {
+		return NULL;
+	}
+
+	uint32_t fileSize = header->fileSize;
+	if(!levelSectionFits(header->tilesOffset, (uint32_t)header->width*header->height, 1, fileSize) ||
+		!levelSectionFits(header->chunksOffset, (uint32_t)header->chunksX*header->chunksY, sizeof(LevelChunk), fileSize) ||
+		!levelSectionFits(header->quadsOffset, header->numQuads, sizeof(LevelQuad), fileSize) ||
+		!levelSectionFits(header->rowsOffset, header->height, sizeof(LevelRow), fileSize) ||
+		!levelSectionFits(header->spansOffset, header->numSpans, sizeof(LevelSpan), fileSize)) {
+		return NULL;
+	}
+
+	// tile bytes are not scanned, the game treats unknown types as empty
+	const uint8_t *base = (const uint8_t *)data;
+	const LevelChunk *chunks = (const LevelChunk *)(base + header->chunksOffset);
+	for(uint32_t i = 0; i < (uint32_t)header->chunksX*header->chunksY; i++) {
+		if(chunks[i].firstQuad > header->numQuads || chunks[i].numQuads > header->numQuads - chunks[i].firstQuad) {
+			return NULL;
+		}
+	}
+	const LevelRow *rows = (const LevelRow *)(base + header->rowsOffset);
+	const LevelSpan *spans = (const LevelSpan *)(base + header->spansOffset);
+	for(uint32_t y = 0; y < header->height; y++) {
+		if(rows[y].firstSpan > header->numSpans || rows[y].numSpans > header->numSpans - rows[y].firstSpan) {
+			return NULL;
+		}
+		for(uint32_t s = rows[y].firstSpan; s < rows[y].firstSpan + rows[y].numSpans; s++) {
+			if(spans[s].xBegin >= spans[s].xEnd || spans[s].xEnd > header->width || spans[s].type >= TileNumElements) {
+				return NULL;
+			}
+		}
+	}
+	return header;
+}
@@ -0,0 +1,234 @@
+#pragma once
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "levelFormat.h"
+
+// Seeded procedural levels: bands of one-way platforms joined by ladders.
+//
+// The map is cut into vertical strips that are generated independently, so strips run in parallel
+// and the result only depends on the seed, never on the thread count.
+// Inside a strip, working up from the ground, every platform run gets a ladder from the first
+// surface below it, so everything can be reached by walking, climbing and dropping down.
+// Jumps aren't needed, so that holds at any tile size.
+
+const int LevelGenStripWidth = 64;  // tiles
+const int LevelGenBandHeight = 4;   // tiles from one platform row to the next, at most
+const int LevelGenMinBandHeight = 3;
+const int LevelGenHeadroomDivisor = 8; // at least 1/8 of the rows stay empty above the top band, the player is 1.75 m of 15
+
+inline uint32_t levelGenRandom(uint32_t &state) {
+	// xorshift32
+	uint32_t x = state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	state = x;
+	return x;
+}
+
+// a platform, or the top of a ladder
+inline bool isLevelSurface(const LevelSource &src, int x, int y) {
+	uint8_t type = src.types[y*src.width + x];
+	if(type == TilePlatform) {
+		return true;
+	}
+	return type == TileLadder && (y + 1 == src.height || src.types[(y + 1)*src.width + x] != TileLadder);
+}
+
+// bands get closer on short maps so they still get a few, a map is always WorldHeight tall
+// so its tiles are taller too
+inline int levelGenBandHeight(int height) {
+	int bandHeight = height / 4;
+	bandHeight = (bandHeight > LevelGenMinBandHeight) ? bandHeight : LevelGenMinBandHeight;
+	return (bandHeight < LevelGenBandHeight) ? bandHeight : LevelGenBandHeight;
+}
+
+// at least a band of empty rows is left above the top one, more on tall maps, so there's headroom to stand there
+inline int levelGenHeadroom(int height) {
+	int headroom = (height + LevelGenHeadroomDivisor - 1) / LevelGenHeadroomDivisor;
+	int bandHeight = levelGenBandHeight(height);
+	return (headroom > bandHeight) ? headroom : bandHeight;
+}
+
+// whether the lowest band fits under the headroom, a shorter map would come out empty
+inline bool levelGenFitsBand(int height) {
+	return levelGenBandHeight(height) - 1 + levelGenHeadroom(height) < height;
+}
+
+// columns [stripX, stripEnd), every row
+inline void generateLevelStrip(LevelSource &src, int stripX, int stripEnd, uint32_t seed) {
+	struct Run {
+		int x;
+		int end;
+		int y;
+	};
+
+	uint32_t random = (seed ^ ((uint32_t)stripX * 0x9E3779B9)) | 1;
+	levelGenRandom(random);
+	int width = src.width;
+	uint8_t *types = &src.types[0];
+
+	// platform runs, one row per band with some wobble
+	int bandHeight = levelGenBandHeight(src.height);
+	int headroom = levelGenHeadroom(src.height);
+	std::vector<Run> runs;
+	for(int bandY = bandHeight - 1; bandY + headroom < src.height; bandY += bandHeight) {
+		int x = stripX + (int)(levelGenRandom(random) % 4);
+		while(x < stripEnd) {
+			int end = x + 2 + (int)(levelGenRandom(random) % 11);
+			end = (end < stripEnd) ? end : stripEnd;
+			Run run = {x, end, bandY - (int)(levelGenRandom(random) % 2)};
+			for(int i = run.x; i < run.end; i++) {
+				types[run.y*width + i] = (uint8_t)TilePlatform;
+			}
+			runs.push_back(run);
+			x = end + 1 + (int)(levelGenRandom(random) % 8);
+		}
+	}
+
+	// ladders, lowest runs first so the surface a ladder stands on is already reachable
+	// insertion sort, runs are nearly sorted already
+	for(size_t i = 1; i < runs.size(); i++) {
+		Run run = runs[i];
+		size_t j = i;
+		for(; j > 0 && runs[j - 1].y > run.y; j--) {
+			runs[j] = runs[j - 1];
+		}
+		runs[j] = run;
+	}
+	for(size_t i = 0; i < runs.size(); i++) {
+		Run &run = runs[i];
+		int length = run.end - run.x;
+		int start = (int)(levelGenRandom(random) % length);
+		bool placed = false;
+		for(int n = 0; n < length && !placed; n++) {
+			int x = run.x + (start + n) % length;
+			int below = run.y - 1;
+			while(below >= 0 && types[below*width + x] == TileNone) {
+				below--;
+			}
+			// standing on another ladder's top would turn it into the middle of a ladder
+			if(below >= 0 && types[below*width + x] != TilePlatform) {
+				continue;
+			}
+			for(int y = below + 1; y <= run.y; y++) {
+				types[y*width + x] = (uint8_t)TileLadder;
+			}
+			placed = true;
+		}
+		if(!placed) {
+			// every column is right above a ladder top, a run nothing can reach is worse than none
+			for(int x = run.x; x < run.end; x++) {
+				types[run.y*width + x] = (uint8_t)TileNone;
+			}
+		}
+	}
+
+	// the tile graphic is the tileset tile with the same index as the type, like TileMap.txt
+	std::vector<uint16_t> &graphics = src.layers[0];
+	for(int y = 0; y < src.height; y++) {
+		for(int x = stripX; x < stripEnd; x++) {
+			uint8_t type = types[y*width + x];
+			graphics[y*width + x] = (type == TileNone) ? LevelNoGraphic : (uint16_t)type;
+		}
+	}
+}
+
+// strips first, first + step, first + 2*step...
+inline void generateLevelStrips(LevelSource *src, uint32_t seed, int first, int step) {
+	for(int stripX = first*LevelGenStripWidth; stripX < src->width; stripX += step*LevelGenStripWidth) {
+		int stripEnd = stripX + LevelGenStripWidth;
+		generateLevelStrip(*src, stripX, (stripEnd < src->width) ? stripEnd : src->width, seed);
+	}
+}
+
+// strips write disjoint columns of the same arrays, no locking needed
+inline void generateLevel(LevelSource &src, int width, int height, uint32_t seed, int numThreads) {
+	src.width = width;
+	src.height = height;
+	src.types.assign(width*height, TileNone);
+	src.layers.assign(1, std::vector<uint16_t>(width*height, LevelNoGraphic));
+
+	int numStrips = (width + LevelGenStripWidth - 1) / LevelGenStripWidth;
+	numThreads = (numThreads < numStrips) ? numThreads : numStrips;
+	numThreads = (numThreads > 1) ? numThreads : 1;
+	std::vector<std::thread> threads;
+	for(int i = 1; i < numThreads; i++) {
+		threads.push_back(std::thread(generateLevelStrips, &src, seed, i, numThreads));
+	}
+	generateLevelStrips(&src, seed, 0, numThreads);
+	for(size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+}
+
+// surfaces that can't be reached from the ground by walking, climbing ladders and dropping down
+// a player stands at (x, y) with their feet on top of row y - 1, y == 0 is the ground
+inline int countUnreachableSurfaces(const LevelSource &src) {
+	int width = src.width;
+	int height = src.height;
+
+	// standing row after falling from row y of column x
+	std::vector<int> landing(width*(height + 1));
+	for(int x = 0; x < width; x++) {
+		int land = 0;
+		for(int y = 0; y <= height; y++) {
+			landing[y*width + x] = land;
+			if(y < height && isLevelSurface(src, x, y)) {
+				land = y + 1;
+			}
+		}
+	}
+
+	std::vector<uint8_t> visited(width*(height + 1), 0);
+	std::vector<int> queue;
+	for(int x = 0; x < width; x++) {
+		visited[x] = 1;
+		queue.push_back(x);
+	}
+	for(size_t head = 0; head < queue.size(); head++) {
+		int x = queue[head] % width;
+		int y = queue[head] / width;
+		int next[4];
+		int numNext = 0;
+
+		// walk, or walk off the edge and fall
+		for(int side = -1; side <= 1; side += 2) {
+			int nx = x + side;
+			if(nx >= 0 && nx < width) {
+				bool supported = (y == 0) || isLevelSurface(src, nx, y - 1);
+				next[numNext++] = (supported ? y : landing[y*width + nx])*width + nx;
+			}
+		}
+		// drop down through what we stand on
+		if(y > 0) {
+			next[numNext++] = landing[(y - 1)*width + x]*width + x;
+		}
+		// climb a ladder that starts here all the way up
+		if(y < height && src.types[y*width + x] == TileLadder) {
+			int top = y;
+			while(top + 1 < height && src.types[(top + 1)*width + x] == TileLadder) {
+				top++;
+			}
+			next[numNext++] = (top + 1)*width + x;
+		}
+
+		for(int i = 0; i < numNext; i++) {
+			if(!visited[next[i]]) {
+				visited[next[i]] = 1;
+				queue.push_back(next[i]);
+			}
+		}
+	}
+
+	int numUnreachable = 0;
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			if(isLevelSurface(src, x, y) && !visited[(y + 1)*width + x]) {
+				numUnreachable++;
+			}
+		}
+	}
+	return numUnreachable;
+}
@@ -0,0 +1,262 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// per-tile light, spread from light sources with a breadth-first flood fill
+// light drops by one per tile and doesn't pass through opaque tiles: they are lit, but only spread their own emission
+//
+// changes are incremental: removing light zeroes only the tiles that could have depended on it,
+// then refills them from the edge of that area, so the work is bounded by the light radius, not the map
+
+const uint8_t MaxLightLevel = 15;
+const int MaxNumLights = 256;
+
+struct LightSource {
+	int x;
+	int y;
+	uint8_t level;
+	bool isActive;
+};
+
+struct LightNode {
+	int index;
+	uint8_t level;
+};
+
+struct LightMap {
+	int width = 0;
+	int height = 0;
+	uint8_t *light = NULL;     // current level per tile, [y*width + x]
+	uint8_t *emission = NULL;  // strongest source on each tile
+	uint8_t *opaque = NULL;
+
+	LightSource sources[MaxNumLights];
+	int numSources = 0;
+
+	// work queues, emptied after every change but keep their memory
+	std::vector<int> spreadQueue;
+	std::vector<LightNode> removeQueue;
+
+	// tiles changed since the last clearLightDirty, inclusive
+	int dirtyMinX, dirtyMinY, dirtyMaxX, dirtyMaxY;
+};
+
+inline void clearLightDirty(LightMap &lights) {
+	lights.dirtyMinX = lights.width;
+	lights.dirtyMinY = lights.height;
+	lights.dirtyMaxX = -1;
+	lights.dirtyMaxY = -1;
+}
+
+inline bool isLightDirty(LightMap &lights) {
+	return lights.dirtyMaxX >= lights.dirtyMinX;
+}
+
+inline void markLightDirty(LightMap &lights, int index) {
+	int x = index % lights.width;
+	int y = index / lights.width;
+	if(x < lights.dirtyMinX) lights.dirtyMinX = x;
+	if(x > lights.dirtyMaxX) lights.dirtyMaxX = x;
+	if(y < lights.dirtyMinY) lights.dirtyMinY = y;
+	if(y > lights.dirtyMaxY) lights.dirtyMaxY = y;
+}
+
+// opaque is width*height flags, copied so tiles can change without touching the level
+inline void initLightMap(LightMap &lights, int width, int height, const uint8_t *opaque) {
+	int numTiles = width*height;
+	lights.width = width;
+	lights.height = height;
+	lights.light = new uint8_t[numTiles]();
+	lights.emission = new uint8_t[numTiles]();
+	lights.opaque = new uint8_t[numTiles];
+	memcpy(lights.opaque, opaque, numTiles);
+	// a light of MaxLightLevel reaches about 2*15*15 tiles
+	lights.spreadQueue.reserve(4096);
+	lights.removeQueue.reserve(4096);
+	lights.numSources = 0;
+	clearLightDirty(lights);
+	lights.dirtyMinX = lights.dirtyMinY = 0;
+	lights.dirtyMaxX = width - 1;
+	lights.dirtyMaxY = height - 1;
+}
+
+inline void freeLightMap(LightMap &lights) {
+	delete[] lights.light;
+	delete[] lights.emission;
+	delete[] lights.opaque;
+	lights.light = lights.emission = lights.opaque = NULL;
+	lights.spreadQueue = std::vector<int>();
+	lights.removeQueue = std::vector<LightNode>();
+	lights.numSources = 0;
+}
+
+inline void pushSpread(LightMap &lights, int index) {
+	lights.spreadQueue.push_back(index);
+}
+
+inline void pushRemove(LightMap &lights, int index, uint8_t level) {
+	LightNode node = {index, level};
+	lights.removeQueue.push_back(node);
+}
+
+// runs body with neighbor set to each of the 4 neighbors of index that are on the map
+#define FOR_EACH_LIGHT_NEIGHBOR(lights, index, neighbor, body) { \
+	int x_ = (index) % (lights).width; \
+	int y_ = (index) / (lights).width; \
+	int neighbor; \
+	if(x_ > 0) { neighbor = (index) - 1; body } \
+	if(x_ < (lights).width - 1) { neighbor = (index) + 1; body } \
+	if(y_ > 0) { neighbor = (index) - (lights).width; body } \
+	if(y_ < (lights).height - 1) { neighbor = (index) + (lights).width; body } \
+}
+
+// removal pass first, it hands the edge of the cleared area to the spread pass
+inline void runLightQueues(LightMap &lights) {
+	for(size_t head = 0; head < lights.removeQueue.size(); head++) {
+		LightNode node = lights.removeQueue[head];
+		FOR_EACH_LIGHT_NEIGHBOR(lights, node.index, neighbor,
+			uint8_t level = lights.light[neighbor];
+			if(level != 0 && level < node.level) {
+				// may have been lit through this tile, clear it too
+				lights.light[neighbor] = 0;
+				markLightDirty(lights, neighbor);
+				pushRemove(lights, neighbor, level);
+			} else if(level >= node.level) {
+				// lit from somewhere else, refill from here
+				pushSpread(lights, neighbor);
+			}
+		)
+		if(lights.emission[node.index] > lights.light[node.index]) {
+			lights.light[node.index] = lights.emission[node.index];
+			markLightDirty(lights, node.index);
+			pushSpread(lights, node.index);
+		}
+	}
+	lights.removeQueue.clear();
+
+	for(size_t head = 0; head < lights.spreadQueue.size(); head++) {
+		int index = lights.spreadQueue[head];
+		uint8_t level = lights.opaque[index] ? lights.emission[index] : lights.light[index];
+		if(level <= 1) {
+			continue;
+		}
+		FOR_EACH_LIGHT_NEIGHBOR(lights, index, neighbor,
+			if(lights.light[neighbor] < level - 1) {
+				lights.light[neighbor] = level - 1;
+				markLightDirty(lights, neighbor);
+				pushSpread(lights, neighbor);
+			}
+		)
+	}
+	lights.spreadQueue.clear();
+}
+
+// takes the light of a tile away, then lets everything that's left flow back in
+inline void removeTileLight(LightMap &lights, int index) {
+	uint8_t level = lights.light[index];
+	if(level == 0) {
+		return;
+	}
+	lights.light[index] = 0;
+	markLightDirty(lights, index);
+	pushRemove(lights, index, level);
+}
+
+inline void updateTileEmission(LightMap &lights, int index) {
+	uint8_t emission = 0;
+	for(int i = 0; i < lights.numSources; i++) {
+		LightSource &source = lights.sources[i];
+		if(source.isActive && source.y*lights.width + source.x == index && source.level > emission) {
+			emission = source.level;
+		}
+	}
+
+	uint8_t oldEmission = lights.emission[index];
+	lights.emission[index] = emission;
+	if(emission < oldEmission) {
+		removeTileLight(lights, index);
+	} else if(emission > oldEmission) {
+		if(emission > lights.light[index]) {
+			lights.light[index] = emission;
+			markLightDirty(lights, index);
+		}
+		pushSpread(lights, index);
+	}
+	runLightQueues(lights);
+}
+
+// returns a handle for moveLight/removeLight, or -1 when there's no free slot
+inline int addLight(LightMap &lights, int x, int y, uint8_t level) {
+	int handle = -1;
+	for(int i = 0; i < lights.numSources && handle < 0; i++) {
+		if(!lights.sources[i].isActive) {
+			handle = i;
+		}
+	}
+	if(handle < 0) {
+		if(lights.numSources == MaxNumLights) {
+			return -1;
+		}
+		handle = lights.numSources++;
+	}
+
+	if(x < 0) x = 0;
+	if(y < 0) y = 0;
+	if(x >= lights.width) x = lights.width - 1;
+	if(y >= lights.height) y = lights.height - 1;
+
+	LightSource &source = lights.sources[handle];
+	source.x = x;
+	source.y = y;
+	source.level = (level > MaxLightLevel) ? MaxLightLevel : level;
+	source.isActive = true;
+	updateTileEmission(lights, y*lights.width + x);
+	return handle;
+}
+
+inline void removeLight(LightMap &lights, int handle) {
+	LightSource &source = lights.sources[handle];
+	if(!source.isActive) {
+		return;
+	}
+	source.isActive = false;
+	updateTileEmission(lights, source.y*lights.width + source.x);
+}
+
+// only does work when the light crosses into another tile
+inline void moveLight(LightMap &lights, int handle, int x, int y) {
+	LightSource &source = lights.sources[handle];
+	if(x < 0) x = 0;
+	if(y < 0) y = 0;
+	if(x >= lights.width) x = lights.width - 1;
+	if(y >= lights.height) y = lights.height - 1;
+	if(!source.isActive || (source.x == x && source.y == y)) {
+		return;
+	}
+	int oldIndex = source.y*lights.width + source.x;
+	source.x = x;
+	source.y = y;
+	updateTileEmission(lights, oldIndex);
+	updateTileEmission(lights, y*lights.width + x);
+}
+
+inline void setTileOpaque(LightMap &lights, int x, int y, bool opaque) {
+	int index = y*lights.width + x;
+	if((lights.opaque[index] != 0) == opaque) {
+		return;
+	}
+	lights.opaque[index] = opaque ? 1 : 0;
+
+	if(opaque) {
+		// take back what the tile passed on, its neighbors light it again as a wall
+		removeTileLight(lights, index);
+	} else {
+		// light can pass now, let it spread on from this tile and its neighbors
+		pushSpread(lights, index);
+		FOR_EACH_LIGHT_NEIGHBOR(lights, index, neighbor,
+			pushSpread(lights, neighbor);
+		)
+	}
+	runLightQueues(lights);
+}
@@ -2,11 +2,63 @@
 #include <SDL_ttf.h>
 #include <SDL_image.h>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
 #include <fstream>
+#include <new>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
 #include <glm/glm.hpp>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "levelFormat.h"
+#include "particles.h"
+#include "lighting.h"
+#include "worldRect.h"
+#include "frameArena.h"
+#include "spriteAtlas.h"
+#include "collisionBatch.h"
 using glm::vec2;
 
+// heap allocation counting, on in debug builds
+// counts everything that goes through operator new, SDL's own allocations aren't seen
+#ifdef TRACK_ALLOCATIONS
+std::atomic<int> NumHeapAllocations(0);
+
+void *operator new(size_t size) {
+	NumHeapAllocations++;
+	void *memory = malloc(size ? size : 1);
+	if(memory == NULL) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *memory) throw() {
+	free(memory);
+}
+
+void operator delete[](void *memory) throw() {
+	free(memory);
+}
+#endif
+
 inline void LogError() {
 	SDL_Log(SDL_GetError());
 }
@@ -33,37 +85,6 @@ int clamp(int val, int min, int max) {
 	return val;
 }
 
-struct WorldRect {
-	float x;
-	float y;
-	float w;
-	float h;
-};
-
-bool xOverlap(WorldRect &a, WorldRect &b) {
-	return a.x + a.w > b.x && a.x < b.x + b.w;
-}
-
-bool yOverlap(WorldRect &a, WorldRect &b) {
-	return a.y + a.h > b.y && a.y < b.y + b.h;
-}
-
-bool standingOn(WorldRect &a, WorldRect &b) {
-	return a.y == b.y + b.h;
-}
-
-bool isAbove(WorldRect &a, WorldRect &b) {
-	return a.y >= b.y + b.h;
-}
-
-bool isBelowBottom(WorldRect &a, WorldRect &b) {
-	return a.y < b.y;
-}
-
-bool isBelowTop(WorldRect &a, WorldRect &b) {
-	return a.y < b.y + b.h;
-}
-
 struct ScreenProperties {
 	int screenWidth;
 	int screenHeight;
@@ -73,18 +94,45 @@ struct ScreenProperties {
 
 // creates an SDL_Rect from WorldRect, based on screen properties
 void worldRectToRenderRect(WorldRect &wRect, SDL_Rect &rRect, ScreenProperties &screenProps) {
-	rRect.w = (int)(wRect.w * screenProps.pixPerHorizontalMeter);
-	rRect.h = (int)(wRect.h * screenProps.pixPerVerticalMeter);
-	rRect.x = (int)(wRect.x * screenProps.pixPerHorizontalMeter);
-	rRect.y = screenProps.screenHeight - ((int)(wRect.y * screenProps.pixPerVerticalMeter) + rRect.h);
+	rRect.w = (int)(toMeters(wRect.w) * screenProps.pixPerHorizontalMeter);
+	rRect.h = (int)(toMeters(wRect.h) * screenProps.pixPerVerticalMeter);
+	rRect.x = (int)(toMeters(wRect.x) * screenProps.pixPerHorizontalMeter);
+	rRect.y = screenProps.screenHeight - ((int)(toMeters(wRect.y) * screenProps.pixPerVerticalMeter) + rRect.h);
 }
 
-enum TileType {
-	TileNone = 0,
-	TilePlatform = 1,
-	TileLadder = 2,
-	TileNumElements
-};
+// where the world target goes in the window, centered with black bars
+// whole multiples of the target's pixels, as close to the world's aspect as they get, when the window has room,
+// otherwise scaled to fit at the world's aspect
+SDL_Rect worldViewRect(int windowWidth, int windowHeight, int targetWidth, int targetHeight, float aspect) {
+	SDL_Rect view = {0, 0, 0, 0};
+	int maxScaleX = windowWidth / targetWidth;
+	int maxScaleY = windowHeight / targetHeight;
+	if(maxScaleX >= 1 && maxScaleY >= 1) {
+		int scaleY = maxScaleY;
+		int scaleX = max((int)(scaleY * targetHeight * aspect / targetWidth + 0.5f), 1);
+		if(scaleX > maxScaleX) {
+			scaleX = maxScaleX;
+			scaleY = clamp((int)(scaleX * targetWidth / (aspect * targetHeight) + 0.5f), 1, maxScaleY);
+		}
+		// too few whole steps to get near the aspect, a thin window say
+		float stretch = (float)(scaleX * targetWidth) / (scaleY * targetHeight) / aspect;
+		if(stretch > 0.8f && stretch < 1.25f) {
+			view.w = targetWidth * scaleX;
+			view.h = targetHeight * scaleY;
+		}
+	}
+	if(view.w == 0) {
+		view.w = windowWidth;
+		view.h = (int)(windowWidth / aspect);
+		if(view.h > windowHeight) {
+			view.h = windowHeight;
+			view.w = (int)(windowHeight * aspect);
+		}
+	}
+	view.x = (windowWidth - view.w) / 2;
+	view.y = (windowHeight - view.h) / 2;
+	return view;
+}
 
 enum TileSolidity {
 	TsNonSolid,
@@ -94,10 +142,10 @@ enum TileSolidity {
 };
 
 struct TileImpl {
-	float hitboxOffsetX;
-	float hitboxOffsetY;
-	float hitboxWidth;
-	float hitboxHeight;
+	WorldCoord hitboxOffsetX;
+	WorldCoord hitboxOffsetY;
+	WorldCoord hitboxWidth;
+	WorldCoord hitboxHeight;
 	TileSolidity solidity;
 };
 
@@ -105,13 +153,8 @@ TileImpl TileCommon[TileType::TileNumElements];
 
 struct Tile {
 	TileType type = TileType::TileNone;
-	float xPos = 0.0f;
-	float yPos = 0.0f;
-	TileImpl *common = NULL;
-	//float hitboxWidth;
-	//float hitboxHeight;
-	//TileSolidity solidity;
-	bool isOccupied = false;
+	int x = 0;
+	int y = 0;
 };
 
 enum PlayerState {
@@ -163,148 +206,1288 @@ void changeFrame(Input &input) {
 	for(int i = 0; i < NumButtons; i++) {
 		input.buttons[i].wasDown = input.buttons[i].isDown;
 	}
-}
+}
+
+// fills in analog stick values based on movement key values
+// input.stick.end{X/Y} get persisted by function "void changeFrame(Input &input)"
+void buildAnalogInput(Input &input) {
+	if(!input.isAnalog) {
+		input.stick.endX = 0;
+		input.stick.endX += input.arrowRight.isDown;
+		input.stick.endX -= input.arrowLeft.isDown;
+		input.stick.endY = 0;
+		input.stick.endY += input.arrowUp.isDown;
+		input.stick.endY -= input.arrowDown.isDown;
+	}
+}
+
+// the world is sized to fill the default window
+const int DefaultScreenWidth = 1280;
+const int DefaultScreenHeight = 720;
+const float WorldHeight = 15.0f; // meters
+const float WorldWidth = WorldHeight * DefaultScreenWidth / DefaultScreenHeight; // meters
+
+// compiled from res\TileMap.txt before every build, any other .lvl can be passed on the command line
+const char *const DefaultLevelPath = "..\\res\\TileMap.lvl";
+
+SDL_Surface *renderTextBlended(TTF_Font *font, const char *text, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	SDL_Color color = {r, g, b, a};
+	return TTF_RenderText_Blended(font, text, color);
+}
+
+// read-only view of a file mapped into memory
+struct MappedFile {
+	const void *data = NULL;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#endif
+};
+
+bool mapFile(MappedFile &mapped, const char *filename) {
+#ifdef _WIN32
+	mapped.file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(mapped.file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if(GetFileSizeEx(mapped.file, &size) && size.QuadPart > 0) {
+		mapped.mapping = CreateFileMappingA(mapped.file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(mapped.mapping != NULL) {
+			mapped.data = MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0);
+			mapped.size = (size_t)size.QuadPart;
+		}
+	}
+	if(mapped.data == NULL) {
+		if(mapped.mapping != NULL) CloseHandle(mapped.mapping);
+		CloseHandle(mapped.file);
+		mapped = MappedFile();
+		return false;
+	}
+	return true;
+#else
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if(fstat(fd, &info) == 0 && info.st_size > 0) {
+		void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data != MAP_FAILED) {
+			mapped.data = data;
+			mapped.size = (size_t)info.st_size;
+		}
+	}
+	close(fd);
+	return mapped.data != NULL;
+#endif
+}
+
+void unmapFile(MappedFile &mapped) {
+	if(mapped.data == NULL) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(mapped.data);
+	CloseHandle(mapped.mapping);
+	CloseHandle(mapped.file);
+#else
+	munmap((void *)mapped.data, mapped.size);
+#endif
+	mapped = MappedFile();
+}
+
+// compiled level (see levelFormat.h and mapCompiler), used in place
+struct TileMap {
+	int width = 0;
+	int height = 0;
+	float tileWidth = 0.0f;          // meters
+	float tileHeight = 0.0f;         // meters
+	WorldCoord tileWorldWidth = 0;   // the same in world units, tiles are whole multiples of it
+	WorldCoord tileWorldHeight = 0;
+
+	const LevelHeader *header = NULL;
+	const Uint8 *tiles = NULL;       // [y*width + x], row 0 is the bottom row
+	const LevelChunk *chunks = NULL;
+	const LevelQuad *quads = NULL;
+	const LevelRow *rows = NULL;
+	const LevelSpan *spans = NULL;
+
+	MappedFile file;
+};
+
+bool loadTileMap(TileMap &map, const char* filename, float worldWidth, float worldHeight) {
+	if(!mapFile(map.file, filename)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map %s", filename);
+		return false;
+	}
+	map.header = validateLevel(map.file.data, map.file.size);
+	if(map.header == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s is not a compiled level (version %u)", filename, LevelVersion);
+		unmapFile(map.file);
+		return false;
+	}
+
+	const Uint8 *base = (const Uint8 *)map.file.data;
+	map.width = map.header->width;
+	map.height = map.header->height;
+	map.tiles = base + map.header->tilesOffset;
+	map.chunks = (const LevelChunk *)(base + map.header->chunksOffset);
+	map.quads = (const LevelQuad *)(base + map.header->quadsOffset);
+	map.rows = (const LevelRow *)(base + map.header->rowsOffset);
+	map.spans = (const LevelSpan *)(base + map.header->spansOffset);
+
+	// round the tile size once, every tile edge is then an exact multiple of it
+	map.tileWorldWidth = toWorld(worldWidth / map.width);
+	map.tileWorldHeight = toWorld(worldHeight / map.height);
+	map.tileWidth = toMeters(map.tileWorldWidth);
+	map.tileHeight = toMeters(map.tileWorldHeight);
+
+	WorldCoord w = map.tileWorldWidth;
+	WorldCoord h = map.tileWorldHeight;
+	TileCommon[TileType::TileNone] = TileImpl {0, 0, w, h, TileSolidity::TsNonSolid};
+	TileCommon[TileType::TileLadder] = TileImpl {0, 0, w, h, TileSolidity::TsTransientSolid};
+	TileCommon[TileType::TilePlatform] = TileImpl {0, 0, w, h, TileSolidity::TsTransientSolid};
+	return true;
+}
+
+void unloadTileMap(TileMap &map) {
+	unmapFile(map.file);
+	map = TileMap();
+}
+
+TileType getTileType(TileMap &map, int x, int y) {
+	Uint8 type = map.tiles[y*map.width + x];
+	return (type < TileType::TileNumElements) ? (TileType)type : TileType::TileNone;
+}
+
+Tile getTile(TileMap &map, int x, int y) {
+	Tile tile;
+	tile.type = getTileType(map, x, y);
+	tile.x = x;
+	tile.y = y;
+	return tile;
+}
+
+// hitbox of a tile, positions come from the grid so nothing is stored per tile
+WorldRect tileRect(TileMap &map, Tile &tile) {
+	TileImpl &common = TileCommon[tile.type];
+	WorldRect rect = {
+		tile.x*map.tileWorldWidth + common.hitboxOffsetX,
+		tile.y*map.tileWorldHeight + common.hitboxOffsetY,
+		common.hitboxWidth,
+		common.hitboxHeight
+	};
+	return rect;
+}
+
+struct OccupiedTiles {
+	static const int MaxNumOccupiedTiles = 20;
+	Tile playerOccupiedTiles[MaxNumOccupiedTiles] = {};
+	int numOccupiedTiles = 0;
+	int iter = 0;
+
+	bool hasNext() {
+		if(iter < numOccupiedTiles) {
+			return true;
+		} else {
+			iter = 0;
+			return false;
+		}
+	}
+
+	Tile next() {
+		return playerOccupiedTiles[iter++];
+	}
+
+	void removeCurrent() {
+		iter--;
+		iter = clamp(iter, 0, numOccupiedTiles-1);
+		playerOccupiedTiles[iter] = playerOccupiedTiles[numOccupiedTiles - 1];
+		playerOccupiedTiles[numOccupiedTiles - 1] = Tile();
+		numOccupiedTiles--;
+	}
+
+	void add(Tile &tile) {
+		bool alreadyExists = false;
+		for(int i = 0; i < numOccupiedTiles && !alreadyExists; i++) {
+			alreadyExists = (tile.x == playerOccupiedTiles[i].x && tile.y == playerOccupiedTiles[i].y);
+		}
+		if(!alreadyExists && numOccupiedTiles < MaxNumOccupiedTiles) {
+			playerOccupiedTiles[numOccupiedTiles++] = tile;
+		}
+	}
+};
+
+struct Projectile {
+	float x;        // meters
+	float y;        // meters
+	float xVel;     // meters per second
+	float yVel;     // meters per second
+	float timeLeft; // seconds
+};
+
+// fixed-capacity pool, live projectiles are packed at the front
+// spawning takes the next free slot and despawning swaps the last one in, so neither allocates
+struct ProjectilePool {
+	static const int MaxNumProjectiles = 2048;
+	Projectile projectiles[MaxNumProjectiles];
+	int numProjectiles = 0;
+
+	Projectile *spawn() {
+		if(numProjectiles == MaxNumProjectiles) {
+			return NULL;
+		}
+		return &projectiles[numProjectiles++];
+	}
+
+	void despawn(int index) {
+		projectiles[index] = projectiles[--numProjectiles];
+	}
+};
+
+// returns the t (in [0,1]) where the segment start + t*delta enters rect
+bool segmentHitsRect(float startX, float startY, float deltaX, float deltaY, WorldRect &rect, float &hitT) {
+	float tMin = 0.0f;
+	float tMax = 1.0f;
+
+	float start[2] = {startX, startY};
+	float delta[2] = {deltaX, deltaY};
+	float rectMin[2] = {toMeters(rect.x), toMeters(rect.y)};
+	float rectMax[2] = {toMeters(rect.x + rect.w), toMeters(rect.y + rect.h)};
+	for(int axis = 0; axis < 2; axis++) {
+		if(delta[axis] == 0.0f) {
+			if(start[axis] < rectMin[axis] || start[axis] > rectMax[axis]) {
+				return false;
+			}
+		} else {
+			float t0 = (rectMin[axis] - start[axis]) / delta[axis];
+			float t1 = (rectMax[axis] - start[axis]) / delta[axis];
+			if(t0 > t1) {
+				float temp = t0;
+				t0 = t1;
+				t1 = temp;
+			}
+			tMin = (t0 > tMin) ? t0 : tMin;
+			tMax = (t1 < tMax) ? t1 : tMax;
+			if(tMin > tMax) {
+				return false;
+			}
+		}
+	}
+	hitT = tMin;
+	return true;
+}
+
+// walks every tile the segment start + t*delta (t in [0,1]) passes through, in order (DDA grid traversal),
+// and returns the first t where it touches a platform hitbox
+// no tile on the path is skipped, so a shot can't tunnel through a platform no matter how fast it is
+bool raycastTiles(TileMap &map, float startX, float startY, float deltaX, float deltaY, float &hitT) {
+	int tileX = (int)floorf(startX / map.tileWidth);
+	int tileY = (int)floorf(startY / map.tileHeight);
+	int stepX = (deltaX > 0.0f) ? 1 : -1;
+	int stepY = (deltaY > 0.0f) ? 1 : -1;
+
+	// t it takes to cross one tile, and t at the next tile edge, per axis
+	float tDeltaX = (deltaX != 0.0f) ? map.tileWidth / fabsf(deltaX) : FLT_MAX;
+	float tDeltaY = (deltaY != 0.0f) ? map.tileHeight / fabsf(deltaY) : FLT_MAX;
+	float tMaxX = (deltaX != 0.0f) ? ((tileX + (stepX > 0)) * map.tileWidth - startX) / deltaX : FLT_MAX;
+	float tMaxY = (deltaY != 0.0f) ? ((tileY + (stepY > 0)) * map.tileHeight - startY) / deltaY : FLT_MAX;
+
+	float t = 0.0f;
+	while(t <= 1.0f) {
+		if(tileX >= 0 && tileX < map.width && tileY >= 0 && tileY < map.height) {
+			if(getTileType(map, tileX, tileY) == TileType::TilePlatform) {
+				Tile tile = getTile(map, tileX, tileY);
+				WorldRect wRect = tileRect(map, tile);
+				if(segmentHitsRect(startX, startY, deltaX, deltaY, wRect, hitT)) {
+					return true;
+				}
+			}
+		} else if((tileX < 0 && stepX < 0) || (tileX >= map.width && stepX > 0) ||
+			(tileY < 0 && stepY < 0) || (tileY >= map.height && stepY > 0)) {
+			// left the map and moving away from it
+			return false;
+		}
+
+		if(tMaxX < tMaxY) {
+			t = tMaxX;
+			tMaxX += tDeltaX;
+			tileX += stepX;
+		} else {
+			t = tMaxY;
+			tMaxY += tDeltaY;
+			tileY += stepY;
+		}
+	}
+	return false;
+}
+
+const float PlayerWidth = 0.40f; // meters
+const float PlayerHeight = 1.75f; // meters
+const float PlayerMoveSpeed = 2.68224f; // meters per second
+const float PlayerJumpSpeed = 6.0f; // meters per second
+const float Gravity = -9.8f; // meters per second per second
+
+// everything the player tick reads and writes, besides input and the map
+struct PlayerBody {
+	WorldRect rect = {};
+	float xVel = 0.0f; // meters per second
+	float yVel = 0.0f; // meters per second
+	PlayerState state = PlayerState::PsInAir;
+	bool dropDown = false;
+	OccupiedTiles occupiedTiles;
+};
+
+// tiles around rect that collision looks at, [min, max)
+void collisionWindow(TileMap &map, WorldRect &rect, int &minTileX, int &minTileY, int &maxTileX, int &maxTileY) {
+	minTileX = (int)(rect.x / map.tileWorldWidth) - 1;
+	maxTileX = (int)((rect.x + rect.w) / map.tileWorldWidth) + 2;
+	minTileY = (int)(rect.y / map.tileWorldHeight) - 1;
+	maxTileY = (int)((rect.y + rect.h) / map.tileWorldHeight) + 2;
+
+	maxTileX = min(maxTileX, map.width);
+	maxTileY = min(maxTileY, map.height);
+	minTileX = max(minTileX, 0);
+	minTileY = max(minTileY, 0);
+}
+
+// one step of player movement and tile collision, touches nothing but its arguments
+// so the game and the soak test (-soak) run the exact same code
+void tickPlayer(PlayerBody &player, Input &input, TileMap &map, float dt) {
+	// world edges in world units, on the tile grid
+	WorldCoord worldRight = map.width * map.tileWorldWidth;
+	WorldCoord worldTop = map.height * map.tileWorldHeight;
+
+	// process input based on player state
+	switch(player.state) {
+	case PlayerState::PsInAir:
+		player.xVel = input.stick.endX * PlayerMoveSpeed;
+		player.yVel += Gravity * dt;
+		break;
+
+	case PlayerState::PsOnLadder:
+		if(input.jump.isDown && !input.jump.wasDown) {
+			player.state = PlayerState::PsInAir;
+			player.dropDown = true;
+			player.xVel = input.stick.endX * PlayerMoveSpeed;
+			player.yVel += PlayerJumpSpeed / 3;
+		} else {
+			player.xVel = 0;
+			player.yVel = input.stick.endY * PlayerMoveSpeed;
+		}
+		break;
+
+	case PlayerState::PsOnTransientGround:
+		player.xVel = input.stick.endX * PlayerMoveSpeed;
+		if(input.stick.endY < 0 && input.stick.startY != input.stick.endY) {
+			player.dropDown = true;
+			player.state = PlayerState::PsInAir;
+			player.yVel -= PlayerMoveSpeed;
+		} else if(input.jump.isDown && !input.jump.wasDown) {
+			// jump
+			player.state = PlayerState::PsInAir;
+			player.yVel += PlayerJumpSpeed;
+		}
+		break;
+
+	case PlayerState::PsPsOnSolidGround:
+		player.xVel = input.stick.endX * PlayerMoveSpeed;
+		if(input.jump.isDown && !input.jump.wasDown) {
+			// jump
+			player.state = PlayerState::PsInAir;
+			player.yVel += PlayerJumpSpeed;
+		}
+		break;
+	}
+
+	// move player
+	WorldRect playerPosCopy = player.rect;
+
+	// move x
+	player.rect.x += toWorld(player.xVel * dt);
+	if(player.rect.x < 0) {
+		player.rect.x = 0;
+		player.xVel = 0;
+	} else if(player.rect.x + player.rect.w > worldRight) {
+		player.rect.x = worldRight - player.rect.w;
+		player.xVel = 0;
+	}
+
+	// move y
+	player.rect.y += toWorld(player.yVel * dt);
+	if(player.rect.y <= 0) {
+		player.rect.y = 0;
+		player.yVel = 0;
+		player.state = PlayerState::PsPsOnSolidGround;
+	} else if(player.rect.y + player.rect.h > worldTop) {
+		player.rect.y = worldTop - player.rect.h;
+		player.yVel = 0;
+		player.state = PlayerState::PsInAir;
+	}
+
+	// check previously collided tiles
+	bool isOnTransientGround = false;
+	bool isOnLadder = false;
+	while(player.occupiedTiles.hasNext()) {
+		Tile tile = player.occupiedTiles.next();
+		WorldRect wRect = tileRect(map, tile);
+
+		switch(tile.type) {
+		case TileType::TileNone:
+			break;
+
+		case TileType::TilePlatform:
+			// if the player was on a platform, and the player is on this platform...
+			// then the player is still on a platform
+			if(player.state == PlayerState::PsOnTransientGround) {
+				if(xOverlap(player.rect, wRect) && standingOn(player.rect, wRect)) {
+					isOnTransientGround = true;
+				} else {
+					player.occupiedTiles.removeCurrent();
+					break;
+				}
+			} 
+			break;
+
+		case TileType::TileLadder:
+			if(player.state == PlayerState::PsOnLadder) {
+				if(!player.dropDown &&  xOverlap(player.rect, wRect) && yOverlap(player.rect, wRect)) {
+					isOnLadder = true;
+				} else {
+					player.occupiedTiles.removeCurrent();
+					break;
+				}
+			// else if the player was on a ladder top, and the player is on this ladder top...
+			// then the player is still on this ladder top
+			} else if(player.state == PlayerState::PsOnTransientGround) {
+				if(xOverlap(player.rect, wRect)) {
+					isOnTransientGround = true;
+				} else {
+					player.occupiedTiles.removeCurrent();
+					break;
+				}
+			}
+			break;
+		}
+	}
+
+	// process post tile collision 
+	if(player.state == PlayerState::PsOnLadder && !isOnLadder) {
+		player.state = PlayerState::PsOnTransientGround;
+		player.yVel = 0;
+	} else if((player.state == PlayerState::PsOnLadder && !isOnLadder) ||
+		(player.state == PlayerState::PsOnTransientGround && !isOnTransientGround)) {
+		player.state = PlayerState::PsInAir;
+	}
+
+	isOnLadder = false;
+	isOnTransientGround = false;
+
+	// check current tile collisions
+	int numCollidedTiles = 0;
+	int minTileX, minTileY, maxTileX, maxTileY;
+	collisionWindow(map, player.rect, minTileX, minTileY, maxTileX, maxTileY);
+
+	// walk the precomputed spans of each row, empty tiles are never visited
+	for(int tileY = minTileY; tileY < maxTileY; tileY++) {
+		const LevelRow &row = map.rows[tileY];
+		for(Uint32 spanIndex = row.firstSpan; spanIndex < row.firstSpan + row.numSpans; spanIndex++) {
+			const LevelSpan &span = map.spans[spanIndex];
+			if(span.xBegin >= maxTileX) {
+				break;
+			}
+			int spanMaxX = min(span.xEnd, maxTileX);
+			for(int tileX = max(span.xBegin, minTileX); tileX < spanMaxX; tileX++) {
+				Tile tile = getTile(map, tileX, tileY);
+				WorldRect wRect = tileRect(map, tile);
+
+				switch(tile.type) {
+				case TileType::TileNone:
+					break;
+
+				case TileType::TilePlatform:
+					// if the player was in the air, and was above platform, and is now under top layer...
+					// then player is on the platform
+					if(player.state == PlayerState::PsInAir) {
+						if(!player.dropDown &&
+							isAbove(playerPosCopy, wRect) && xOverlap(playerPosCopy, wRect) &&
+							isBelowTop(player.rect, wRect) && xOverlap(player.rect, wRect)) {
+							// land on platform
+							player.state = PlayerState::PsOnTransientGround;
+							player.yVel = 0;
+							player.rect.y = wRect.y + wRect.h;
+							player.occupiedTiles.add(tile);
+						}
+
+						// if the player was going down a ladder and is now on this platform...
+						// then the player is now on this platform
+					} else if(player.state == PlayerState::PsOnLadder) {
+						if(player.yVel < 0 && xOverlap(player.rect, wRect) && isBelowTop(player.rect, wRect)) {
+							// land on platform
+							player.state = PlayerState::PsOnTransientGround;
+							player.yVel = 0;
+							player.rect.y = wRect.y + wRect.h;
+							player.occupiedTiles.add(tile);
+						}
+					}
+					break;
+
+				case TileType::TileLadder:
+					// if the player is on a ladder, and is vertically on this ladder...
+					// then the player is still on this ladder
+					if(player.state == PlayerState::PsOnLadder) {
+						if(!player.dropDown && xOverlap(player.rect, wRect) &&
+							!yOverlap(playerPosCopy, wRect) && yOverlap(player.rect, wRect)) {
+
+							player.occupiedTiles.add(tile);
+						}
+					} else {
+
+						// if the player was not on a ladder, and the player presses up or down,
+						// and the player is overlapping this ladder...
+						// then the player is now on this ladder
+						if(/*!player.dropDown &&*/ input.stick.startY != input.stick.endY &&
+							(input.stick.endY > 0 || input.stick.endY < 0)) {
+							if(xOverlap(player.rect, wRect) && yOverlap(player.rect, wRect)) {
+								isOnLadder = true;
+								player.xVel = 0;
+								player.yVel = 0;
+								// centered on the ladder, but tiles narrower than the player could push it off the edge
+								player.rect.x = wRect.x + (wRect.w - player.rect.w) / 2;
+								player.rect.x = clamp(player.rect.x, (WorldCoord)0, worldRight - player.rect.w);
+								player.occupiedTiles.add(tile);
+							}
+						}
+
+						// if the player was in the air, and was above platform, and is now under top layer,
+						// and this ladder is not below another ladder...
+						// then player is on the ladder top
+						if(player.state == PlayerState::PsInAir) {
+							bool ladderHasNoLadderAboveIt = true;
+							if(tileY < (maxTileY - 1)) {
+								if(getTileType(map, tileX, tileY + 1) == TileType::TileLadder) {
+									ladderHasNoLadderAboveIt = false;
+								}
+							}
+							if(!player.dropDown && ladderHasNoLadderAboveIt &&
+								isAbove(playerPosCopy, wRect) && xOverlap(playerPosCopy, wRect) &&
+								isBelowTop(player.rect, wRect) && xOverlap(player.rect, wRect)) {
+								// land on platform
+								player.state = PlayerState::PsOnTransientGround;
+								player.yVel = 0;
+								player.rect.y = wRect.y + wRect.h; 
+								player.occupiedTiles.add(tile);
+							}
+						}
+
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	if(isOnLadder) {
+		player.state = PlayerState::PsOnLadder;
+	}
+	player.dropDown = false;
+}
+
+const size_t FrameArenaSize = 4 << 20; // bytes, a full set of particle batches is about 2.3 MB
+
+// printable ASCII, rendered once into one texture so drawing text allocates nothing
+const int FirstGlyph = ' ';
+const int NumGlyphs = '~' - ' ' + 1;
+const int GlyphsPerRow = 16;
+
+struct FontAtlas {
+	SDL_Texture *texture = NULL;
+	SDL_Rect glyphs[NumGlyphs];
+	int lineHeight = 0;
+};
+
+bool initFontAtlas(FontAtlas &atlas, SDL_Renderer *renderer, TTF_Font *font, SDL_Color color) {
+	SDL_Surface *glyphSurfaces[NumGlyphs] = {};
+	int cellWidth = 0;
+	int cellHeight = 0;
+	for(int i = 0; i < NumGlyphs; i++) {
+		char text[2] = {(char)(FirstGlyph + i), 0};
+		glyphSurfaces[i] = TTF_RenderText_Blended(font, text, color);
+		if(glyphSurfaces[i] != NULL) {
+			cellWidth = max(cellWidth, glyphSurfaces[i]->w);
+			cellHeight = max(cellHeight, glyphSurfaces[i]->h);
+		}
+	}
+
+	int numRows = (NumGlyphs + GlyphsPerRow - 1) / GlyphsPerRow;
+	SDL_Surface *atlasSurface = SDL_CreateRGBSurface(
+		0, cellWidth*GlyphsPerRow, cellHeight*numRows,
+		32, 0xFF000000, 0x00FF0000, 0X0000FF00, 0X000000FF);
+	for(int i = 0; i < NumGlyphs; i++) {
+		SDL_Rect &glyph = atlas.glyphs[i];
+		glyph.x = (i % GlyphsPerRow) * cellWidth;
+		glyph.y = (i / GlyphsPerRow) * cellHeight;
+		glyph.w = 0;
+		glyph.h = cellHeight;
+		if(glyphSurfaces[i] != NULL) {
+			glyph.w = glyphSurfaces[i]->w;
+			// copy the glyph's alpha as is, blending onto the empty atlas would lose it
+			SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(glyphSurfaces[i], NULL, atlasSurface, &glyph);
+			SDL_FreeSurface(glyphSurfaces[i]);
+		}
+	}
+	atlas.lineHeight = cellHeight;
+	atlas.texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+	SDL_FreeSurface(atlasSurface);
+	return atlas.texture != NULL;
+}
+
+void freeFontAtlas(FontAtlas &atlas) {
+	SDL_DestroyTexture(atlas.texture);
+	atlas.texture = NULL;
+}
+
+// formats into the frame arena and draws glyph by glyph from the atlas
+void printText(FrameArena &arena, SDL_Renderer *renderer, FontAtlas &atlas, int lineNum, const char *fmt, ...)
+{
+	va_list argList;
+	va_start(argList, fmt);
+	char *text = arenaVprintf(arena, fmt, argList);
+	va_end(argList);
+	if(text == NULL) {
+		return;
+	}
+
+	SDL_Rect screenDest;
+	screenDest.x = 0;
+	screenDest.y = atlas.lineHeight * lineNum;
+	screenDest.h = atlas.lineHeight;
+	for(const char *c = text; *c != 0; c++) {
+		int glyph = (unsigned char)*c - FirstGlyph;
+		if(glyph < 0 || glyph >= NumGlyphs) {
+			glyph = '?' - FirstGlyph;
+		}
+		screenDest.w = atlas.glyphs[glyph].w;
+		SDL_RenderCopy(renderer, atlas.texture, &atlas.glyphs[glyph], &screenDest);
+		screenDest.x += screenDest.w;
+	}
+}
+
+// soak test: 2dRpg -soak [worlds] [ticks] [threads] [seed] [level.lvl]
+// runs many independent players headless on the level, one thread per core, fed random or scripted input,
+// and reports every time the tick leaves a player somewhere it should never be
+
+enum SoakFailure {
+	SoakStuckOnLadder,
+	SoakFellThroughPlatform,
+	SoakOutOfBounds,
+	SoakNumFailures
+};
+
+const char *SoakFailureNames[SoakNumFailures] = {
+	"stuck on ladder",
+	"fell through platform",
+	"out of bounds"
+};
+
+enum SoakButton {
+	SoakUp = 1,
+	SoakDown = 2,
+	SoakLeft = 4,
+	SoakRight = 8,
+	SoakJump = 16
+};
+
+// buttons held for a number of ticks
+struct SoakStep {
+	int buttons;
+	int ticks;
+};
+
+// climbs whatever ladder it walks into, back down, then jumps off
+const SoakStep SoakClimbSteps[] = {
+	{SoakRight, 40}, {SoakUp, 120}, {SoakDown, 120}, {SoakLeft, 40}, {SoakUp, 60},
+	{SoakUp | SoakJump, 2}, {SoakRight, 20}, {SoakDown, 5}, {0, 30}
+};
+
+// hops between platforms, dropping through some of them
+const SoakStep SoakHopSteps[] = {
+	{SoakRight | SoakJump, 10}, {SoakRight, 30}, {0, 2}, {SoakDown, 3}, {0, 40},
+	{SoakLeft | SoakJump, 10}, {SoakLeft, 30}, {SoakJump, 2}, {0, 20}
+};
+
+struct SoakScript {
+	const SoakStep *steps;
+	int numSteps;
+};
+
+const SoakScript SoakScripts[] = {
+	{SoakClimbSteps, (int)(sizeof(SoakClimbSteps) / sizeof(SoakStep))},
+	{SoakHopSteps, (int)(sizeof(SoakHopSteps) / sizeof(SoakStep))}
+};
+const int SoakNumScripts = (int)(sizeof(SoakScripts) / sizeof(SoakScript));
+
+const float SoakDt = 1.0f / 60.0f; // seconds
+const int SoakStuckTicks = 60;     // on a ladder, climbing, without moving
+const int SoakMaxReports = 8;      // failures per thread that get logged in full
+
+struct SoakWorld {
+	PlayerBody player;
+	Input input;
+	Uint32 random;
+	int script;     // index into SoakScripts, -1 for random input
+	int step;
+	int buttons;
+	int ticksLeft;  // until the buttons change
+	int ladderStillTicks;
+};
+
+struct SoakReport {
+	SoakFailure kind;
+	int world;
+	int tick;
+	float x; // meters
+	float y; // meters
+	PlayerState state;
+};
+
+struct SoakResult {
+	double ticks = 0.0;
+	double seconds = 0.0;  // this thread's own run time
+	int failureCounts[SoakNumFailures] = {};
+	SoakReport reports[SoakMaxReports];
+	int numReports = 0;
+};
+
+Uint32 soakRandom(SoakWorld &world) {
+	// xorshift32
+	Uint32 x = world.random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	world.random = x;
+	return x;
+}
+
+// drops the player somewhere random on the map, falling
+void spawnSoakPlayer(SoakWorld &world, TileMap &map) {
+	float x = (soakRandom(world) >> 8) * (1.0f / 16777216.0f);
+	float y = (soakRandom(world) >> 8) * (1.0f / 16777216.0f);
+	world.player = PlayerBody();
+	world.player.rect.w = toWorld(PlayerWidth);
+	world.player.rect.h = toWorld(PlayerHeight);
+	world.player.rect.x = toWorld(x * (map.width*map.tileWidth - PlayerWidth));
+	world.player.rect.y = toWorld(y * (map.height*map.tileHeight - PlayerHeight));
+	world.input = Input();
+	world.step = -1;
+	world.ticksLeft = 0;
+	world.ladderStillTicks = 0;
+}
+
+// every world's input only depends on the seed and its index, not on which thread runs it
+void initSoakWorld(SoakWorld &world, TileMap &map, int index, Uint32 seed) {
+	world.random = (seed ^ ((Uint32)index * 0x9E3779B9)) | 1;
+	world.script = (index % 4 == 3) ? (index / 4) % SoakNumScripts : -1;
+	spawnSoakPlayer(world, map);
+}
+
+void nextSoakInput(SoakWorld &world) {
+	changeFrame(world.input);
+	if(--world.ticksLeft <= 0) {
+		if(world.script >= 0) {
+			const SoakScript &script = SoakScripts[world.script];
+			world.step = (world.step + 1) % script.numSteps;
+			world.buttons = script.steps[world.step].buttons;
+			world.ticksLeft = script.steps[world.step].ticks;
+		} else {
+			Uint32 r = soakRandom(world);
+			int horizontal[3] = {0, SoakLeft, SoakRight};
+			int vertical[4] = {0, 0, SoakUp, SoakDown};
+			world.buttons = horizontal[r % 3] | vertical[(r >> 4) % 4] | (((r >> 8) % 4 == 0) ? SoakJump : 0);
+			world.ticksLeft = 1 + (r >> 12) % 45;
+		}
+	}
+
+	Input &input = world.input;
+	input.arrowUp.isDown = (world.buttons & SoakUp) != 0;
+	input.arrowDown.isDown = (world.buttons & SoakDown) != 0;
+	input.arrowLeft.isDown = (world.buttons & SoakLeft) != 0;
+	input.arrowRight.isDown = (world.buttons & SoakRight) != 0;
+	input.jump.isDown = (world.buttons & SoakJump) != 0;
+	buildAnalogInput(input);
+}
+
+// checks the tick that moved the player from before
+bool checkSoakTick(SoakWorld &world, TileMap &map, WorldRect &before, PlayerState stateBefore, SoakFailure &kind) {
+	PlayerBody &player = world.player;
+	WorldCoord worldRight = map.width * map.tileWorldWidth;
+	WorldCoord worldTop = map.height * map.tileWorldHeight;
+
+	if(player.rect.x < 0 || player.rect.y < 0 ||
+		player.rect.x + player.rect.w > worldRight || player.rect.y + player.rect.h > worldTop) {
+		kind = SoakOutOfBounds;
+		return true;
+	}
+
+	// falling past the top of a platform has to land on it
+	if(stateBefore == PlayerState::PsInAir && player.state == PlayerState::PsInAir && player.rect.y < before.y) {
+		int minTileX, minTileY, maxTileX, maxTileY;
+		collisionWindow(map, player.rect, minTileX, minTileY, maxTileX, maxTileY);
+		for(int tileY = minTileY; tileY < maxTileY; tileY++) {
+			for(int tileX = minTileX; tileX < maxTileX; tileX++) {
+				if(getTileType(map, tileX, tileY) != TileType::TilePlatform) {
+					continue;
+				}
+				Tile tile = getTile(map, tileX, tileY);
+				WorldRect wRect = tileRect(map, tile);
+				if(isAbove(before, wRect) && xOverlap(before, wRect) &&
+					isBelowTop(player.rect, wRect) && xOverlap(player.rect, wRect)) {
+					kind = SoakFellThroughPlatform;
+					return true;
+				}
+			}
+		}
+	}
+
+	// climbing, but not moving, and not against the floor or the top of the world
+	float climb = world.input.stick.endY;
+	if(player.state == PlayerState::PsOnLadder && climb != 0 && player.rect.y == before.y &&
+		!(climb < 0 && player.rect.y == 0) && !(climb > 0 && player.rect.y + player.rect.h == worldTop)) {
+		world.ladderStillTicks++;
+	} else {
+		world.ladderStillTicks = 0;
+	}
+	if(world.ladderStillTicks >= SoakStuckTicks) {
+		kind = SoakStuckOnLadder;
+		return true;
+	}
+	return false;
+}
+
+// runs worlds [firstWorld, endWorld) one after another, respawning a player after each failure
+void runSoakWorlds(TileMap *map, int firstWorld, int endWorld, int numTicks, Uint32 seed, SoakResult *result) {
+	Uint64 start = SDL_GetPerformanceCounter();
+	SoakWorld world;
+	for(int index = firstWorld; index < endWorld; index++) {
+		initSoakWorld(world, *map, index, seed);
+		for(int tick = 0; tick < numTicks; tick++) {
+			nextSoakInput(world);
+			WorldRect before = world.player.rect;
+			PlayerState stateBefore = world.player.state;
+			tickPlayer(world.player, world.input, *map, SoakDt);
+
+			SoakFailure kind;
+			if(checkSoakTick(world, *map, before, stateBefore, kind)) {
+				result->failureCounts[kind]++;
+				if(result->numReports < SoakMaxReports) {
+					SoakReport &report = result->reports[result->numReports++];
+					report.kind = kind;
+					report.world = index;
+					report.tick = tick;
+					report.x = toMeters(world.player.rect.x);
+					report.y = toMeters(world.player.rect.y);
+					report.state = world.player.state;
+				}
+				spawnSoakPlayer(world, *map);
+			}
+		}
+		result->ticks += numTicks;
+	}
+	result->seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+// returns 0 when every world ran clean
+int runSoak(int argc, char *argv[]) {
+#ifdef _WIN32
+	// the game has no console of its own, log to the one it was started from
+	AttachConsole(ATTACH_PARENT_PROCESS);
+#endif
+	int numWorlds = max((argc > 0) ? atoi(argv[0]) : 4096, 1);
+	int numTicks = max((argc > 1) ? atoi(argv[1]) : 3600, 1);
+	int numThreads = (argc > 2) ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+	numThreads = clamp(numThreads, 1, numWorlds);
+	Uint32 seed = (argc > 3) ? (Uint32)strtoul(argv[3], NULL, 10) : 1;
+	const char *levelPath = (argc > 4) ? argv[4] : DefaultLevelPath;
+
+	TileMap map = {};
+	if(!loadTileMap(map, levelPath, WorldWidth, WorldHeight)) {
+		return 1;
+	}
+
+	SDL_Log("soak: %d worlds x %d ticks on %d threads, seed %u, %s (%dx%d tiles)",
+		numWorlds, numTicks, numThreads, seed, levelPath, map.width, map.height);
+	std::vector<SoakResult> results(numThreads);
+	std::vector<std::thread> threads;
+	Uint64 start = SDL_GetPerformanceCounter();
+	for(int i = 0; i < numThreads; i++) {
+		int firstWorld = (int)((long long)numWorlds * i / numThreads);
+		int endWorld = (int)((long long)numWorlds * (i + 1) / numThreads);
+		threads.push_back(std::thread(runSoakWorlds, &map, firstWorld, endWorld, numTicks, seed, &results[i]));
+	}
+	for(int i = 0; i < numThreads; i++) {
+		threads[i].join();
+	}
+	double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+	double ticks = 0.0;
+	int failureCounts[SoakNumFailures] = {};
+	for(int i = 0; i < numThreads; i++) {
+		ticks += results[i].ticks;
+		for(int kind = 0; kind < SoakNumFailures; kind++) {
+			failureCounts[kind] += results[i].failureCounts[kind];
+		}
+	}
+	SDL_Log("soak: %.0f ticks in %.3f s, %.0f ticks/sec", ticks, seconds, ticks / seconds);
+
+	// each thread timed on its own, uneven splits and poor scaling show up as a spread here
+	double minRate = DBL_MAX;
+	double maxRate = 0.0;
+	for(int i = 0; i < numThreads; i++) {
+		double rate = (results[i].seconds > 0.0) ? results[i].ticks / results[i].seconds : 0.0;
+		minRate = (rate < minRate) ? rate : minRate;
+		maxRate = (rate > maxRate) ? rate : maxRate;
+		SDL_Log("soak:   thread %d: %.0f ticks in %.3f s, %.0f ticks/sec", i, results[i].ticks, results[i].seconds, rate);
+	}
+	SDL_Log("soak: per thread min %.0f ticks/sec, max %.0f ticks/sec", minRate, maxRate);
+
+	const char *stateNames[] = {"inAir", "onTransientGround", "onSolidGround", "onLadder"};
+	int numFailures = 0;
+	for(int kind = 0; kind < SoakNumFailures; kind++) {
+		SDL_Log("soak: %s: %d", SoakFailureNames[kind], failureCounts[kind]);
+		numFailures += failureCounts[kind];
+	}
+	for(int i = 0; i < numThreads; i++) {
+		for(int r = 0; r < results[i].numReports; r++) {
+			SoakReport &report = results[i].reports[r];
+			SDL_Log("soak:   %s, world %d tick %d at {%f, %f} %s", SoakFailureNames[report.kind],
+				report.world, report.tick, report.x, report.y, stateNames[report.state]);
+		}
+	}
+
+	unloadTileMap(map);
+	return (numFailures == 0) ? 0 : 2;
+}
+
+// microbenchmark: 2dRpg -bench [rects] [reps] [seed] [level.lvl]
+// times the collision tests and transforms the way the game calls them, one rect at a time by reference over
+// an array of WorldRects, against the batched versions in collisionBatch.h over the same rects as separate
+// arrays, after checking that both give the same answers
+// the rects are tiles of a long made-up level, or hitboxes of the given level's tiles
+
+const int NumBenchMovers = 16;     // player-sized rects, each one is tested against every rect
+const int BenchTilesPerTick = 12;  // OccupiedTiles::add calls between clears, about what a tick adds
+
+struct BenchData {
+	int numRects = 0;
+	std::vector<WorldRect> rects;  // tiles on the grid
+	WorldRectArrays rectArrays;    // the same rects
+	WorldRect movers[NumBenchMovers];
+	TileMap map;                   // the given level, or only a size and tile size for collisionWindow
+	ScreenProperties screenProps;
+	std::vector<int> values;       // for clamp, a lot of them out of range
+	std::vector<Tile> tiles;       // small clusters of tiles for OccupiedTiles::add
+
+	// results, [0] the one at a time version and [1] the batched one, padded to whole lanes
+	std::vector<Uint8> flags[2];   // NumBenchMovers rows of rectArrays.capacity
+	std::vector<SDL_Rect> renderRects[2];
+	std::vector<int> ints[2];
+	std::vector<int> windows[2];   // minX, minY, maxX, maxY rows of rectArrays.capacity
+};
+
+Uint32 benchRandom(Uint32 &state) {
+	// xorshift32
+	Uint32 x = state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	state = x;
+	return x;
+}
+
+bool initBenchData(BenchData &data, int numRects, Uint32 seed, const char *levelPath) {
+	if(levelPath != NULL) {
+		if(!loadTileMap(data.map, levelPath, WorldWidth, WorldHeight)) {
+			return false;
+		}
+	} else {
+		// a long level, tiles the shape of the game's
+		data.map.width = 4096;
+		data.map.height = 256;
+		data.map.tileWorldWidth = toWorld(WorldWidth / 10);
+		data.map.tileWorldHeight = toWorld(WorldHeight / 10);
+		data.map.tileWidth = toMeters(data.map.tileWorldWidth);
+		data.map.tileHeight = toMeters(data.map.tileWorldHeight);
+	}
+	if(!initWorldRectArrays(data.rectArrays, numRects)) {
+		return false;
+	}
+	int capacity = data.rectArrays.capacity;
+	data.numRects = numRects;
+	Uint32 random = seed | 1;
+
+	// a real level's rects are picked from its solid tiles, all of them if it has none
+	std::vector<int> levelTiles;
+	for(int i = 0; data.map.tiles != NULL && i < data.map.width*data.map.height; i++) {
+		if(data.map.tiles[i] != TileType::TileNone) {
+			levelTiles.push_back(i);
+		}
+	}
+	for(int i = 0; data.map.tiles != NULL && levelTiles.empty() && i < data.map.width*data.map.height; i++) {
+		levelTiles.push_back(i);
+	}
+	data.screenProps.screenWidth = data.map.width * 16;
+	data.screenProps.screenHeight = data.map.height * 16;
+	data.screenProps.pixPerHorizontalMeter = 16 / data.map.tileWidth;
+	data.screenProps.pixPerVerticalMeter = 16 / data.map.tileHeight;
+
+	data.rects.resize(numRects);
+	data.values.resize(capacity);
+	data.tiles.resize(numRects);
+	for(int i = 0; i < numRects; i++) {
+		WorldRect rect;
+		if(!levelTiles.empty()) {
+			int index = levelTiles[benchRandom(random) % levelTiles.size()];
+			Tile tile = getTile(data.map, index % data.map.width, index / data.map.width);
+			rect = tileRect(data.map, tile);
+		} else {
+			int tileX = (int)(benchRandom(random) % data.map.width);
+			int tileY = (int)(benchRandom(random) % data.map.height);
+			WorldRect gridRect = {tileX*data.map.tileWorldWidth, tileY*data.map.tileWorldHeight, data.map.tileWorldWidth, data.map.tileWorldHeight};
+			rect = gridRect;
+		}
+		data.rects[i] = rect;
+		setWorldRect(data.rectArrays, i, rect);
+		data.values[i] = (int)(benchRandom(random) % (4 * data.map.width)) - data.map.width;
+	}
 
-// fills in analog stick values based on movement key values
-// input.stick.end{X/Y} get persisted by function "void changeFrame(Input &input)"
-void buildAnalogInput(Input &input) {
-	if(!input.isAnalog) {
-		input.stick.endX = 0;
-		input.stick.endX += input.arrowRight.isDown;
-		input.stick.endX -= input.arrowLeft.isDown;
-		input.stick.endY = 0;
-		input.stick.endY += input.arrowUp.isDown;
-		input.stick.endY -= input.arrowDown.isDown;
+	// some movers stand exactly on a row of tiles, so standingOn isn't always false
+	for(int m = 0; m < NumBenchMovers; m++) {
+		float x = (benchRandom(random) >> 8) * (1.0f / 16777216.0f);
+		float y = (benchRandom(random) >> 8) * (1.0f / 16777216.0f);
+		WorldRect &mover = data.movers[m];
+		mover = worldRectFromMeters(x * data.map.width * data.map.tileWidth, y * data.map.height * data.map.tileHeight, PlayerWidth, PlayerHeight);
+		if(m % 2 == 0) {
+			mover.y = (int)(mover.y / data.map.tileWorldHeight) * data.map.tileWorldHeight;
+		}
 	}
-}
 
-const int textLen = 100;
-char Text[textLen];
+	// the tiles around a player, each one added a few times
+	for(int i = 0; i < numRects; i += BenchTilesPerTick) {
+		int baseX = (int)(benchRandom(random) % max(data.map.width - 3, 1));
+		int baseY = (int)(benchRandom(random) % max(data.map.height - 4, 1));
+		for(int t = i; t < numRects && t < i + BenchTilesPerTick; t++) {
+			data.tiles[t].x = baseX + (int)(benchRandom(random) % 3);
+			data.tiles[t].y = baseY + (int)(benchRandom(random) % 4);
+		}
+	}
 
-SDL_Surface *renderTextBlended(TTF_Font *font, const char *text, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
-	SDL_Color color = {r, g, b, a};
-	return TTF_RenderText_Blended(font, text, color);
+	for(int v = 0; v < 2; v++) {
+		data.flags[v].assign(NumBenchMovers * capacity, 0);
+		data.renderRects[v].resize(capacity);
+		data.ints[v].assign(capacity, 0);
+		data.windows[v].assign(4 * capacity, 0);
+	}
+	return true;
 }
 
-struct TileMap {
-	static const int Width = 10;
-	static const int Height = 10;
-	float tileWidth = 0.0f;
-	float tileHeight = 0.0f;
-
-	Tile tiles[Height][Width];
-};
+template<bool (*Test)(WorldRect &, WorldRect &)>
+void benchRectTest(BenchData &data) {
+	for(int m = 0; m < NumBenchMovers; m++) {
+		WorldRect &a = data.movers[m];
+		Uint8 *out = &data.flags[0][m * data.rectArrays.capacity];
+		for(int i = 0; i < data.numRects; i++) {
+			out[i] = Test(a, data.rects[i]);
+		}
+	}
+}
 
+template<void (*TestMany)(WorldRect &, WorldRectArrays &, uint8_t *)>
+void benchRectTestMany(BenchData &data) {
+	for(int m = 0; m < NumBenchMovers; m++) {
+		TestMany(data.movers[m], data.rectArrays, &data.flags[1][m * data.rectArrays.capacity]);
+	}
+}
 
-void readTileMapText(TileMap &map, const char* filename, float worldWidth, float worldHeight) {
-	map.tileWidth = worldWidth / map.Width;
-	map.tileHeight = worldHeight / map.Height;
+void benchRenderRects(BenchData &data) {
+	for(int i = 0; i < data.numRects; i++) {
+		worldRectToRenderRect(data.rects[i], data.renderRects[0][i], data.screenProps);
+	}
+}
 
-	TileCommon[TileType::TileNone] = TileImpl {0.0f, 0.0f, map.tileWidth, map.tileHeight, TileSolidity::TsNonSolid};
-	TileCommon[TileType::TileLadder] = TileImpl {0.0f, 0.0f, map.tileWidth, map.tileHeight, TileSolidity::TsTransientSolid};
-	TileCommon[TileType::TilePlatform] = TileImpl {0.0f, 0.0f, map.tileWidth, map.tileHeight, TileSolidity::TsTransientSolid};
+void benchRenderRectsMany(BenchData &data) {
+	worldRectsToRenderRects(data.rectArrays, &data.renderRects[1][0],
+		data.screenProps.pixPerHorizontalMeter, data.screenProps.pixPerVerticalMeter, data.screenProps.screenHeight);
+}
 
+void benchClamp(BenchData &data) {
+	for(int i = 0; i < data.numRects; i++) {
+		data.ints[0][i] = clamp(data.values[i], 0, data.map.width - 1);
+	}
+}
 
-	std::ifstream file;
-	std::string line;
-	file.open(filename);
-	if(file.is_open()) {
-		int y = 0;
-		while(getline(file, line)) {
-			for(unsigned int x = 0; x < line.length() && y < TileMap::Height; x++) {
-				TileType type = (TileType)(line.at(x) - '0');
-				Tile *tile = &(map.tiles[((map.Height - 1) - y)][x]);
-				switch(type) {
-				case TileType::TileNone:
-					tile->type = TileType::TileNone;
-					tile->xPos = 0.0f;
-					tile->yPos = 0.0f;
-					tile->common = &TileCommon[TileType::TileNone];
-					break;
+void benchClampMany(BenchData &data) {
+	clampMany(&data.values[0], &data.ints[1][0], data.numRects, 0, data.map.width - 1);
+}
 
-				case TileType::TilePlatform:
-					tile->type = TileType::TilePlatform;
-					tile->xPos = x*map.tileWidth;
-					tile->yPos = ((map.Height - 1) - y)*map.tileHeight;
-					tile->common = &TileCommon[TileType::TilePlatform];
-					break;
+void benchOccupiedTiles(BenchData &data) {
+	OccupiedTiles occupied;
+	for(int i = 0; i < data.numRects; i++) {
+		if(i % BenchTilesPerTick == 0) {
+			occupied.numOccupiedTiles = 0;
+		}
+		occupied.add(data.tiles[i]);
+		data.ints[0][i] = occupied.numOccupiedTiles;
+	}
+}
 
-				case TileType::TileLadder:
-					tile->type = TileType::TileLadder;
-					tile->xPos = x*map.tileWidth;
-					tile->yPos = ((map.Height - 1) - y)*map.tileHeight;
-					tile->common = &TileCommon[TileType::TileLadder];
-					break;
-				}
-			}
-			y++;
+void benchOccupiedTileKeys(BenchData &data) {
+	OccupiedTileKeys occupied;
+	for(int i = 0; i < data.numRects; i++) {
+		if(i % BenchTilesPerTick == 0) {
+			clearOccupiedTileKeys(occupied);
 		}
-		file.close();
+		addOccupiedTileKey(occupied, data.tiles[i].x, data.tiles[i].y);
+		data.ints[1][i] = occupied.numOccupiedTiles;
 	}
 }
 
-struct OccupiedTiles {
-	static const int MaxNumOccupiedTiles = 20;
-	Tile *playerOccupiedTiles[MaxNumOccupiedTiles] = {};
-	int numOccupiedTiles = 0;
-	int iter = 0;
+void benchCollisionWindow(BenchData &data) {
+	int capacity = data.rectArrays.capacity;
+	int *windows = &data.windows[0][0];
+	for(int i = 0; i < data.numRects; i++) {
+		collisionWindow(data.map, data.rects[i], windows[i], windows[capacity + i], windows[2*capacity + i], windows[3*capacity + i]);
+	}
+}
 
-	bool hasNext() {
-		if(iter < numOccupiedTiles) {
-			return true;
-		} else {
-			iter = 0;
+void benchCollisionWindowMany(BenchData &data) {
+	int capacity = data.rectArrays.capacity;
+	int *windows = &data.windows[1][0];
+	collisionWindowMany(data.rectArrays, data.map.tileWorldWidth, data.map.tileWorldHeight, data.map.width, data.map.height,
+		windows, windows + capacity, windows + 2*capacity, windows + 3*capacity);
+}
+
+bool benchFlagsAgree(BenchData &data) {
+	for(int m = 0; m < NumBenchMovers; m++) {
+		int row = m * data.rectArrays.capacity;
+		if(memcmp(&data.flags[0][row], &data.flags[1][row], data.numRects) != 0) {
 			return false;
 		}
 	}
+	return true;
+}
 
-	Tile *next() {
-		return playerOccupiedTiles[iter++];
+bool benchRenderRectsAgree(BenchData &data) {
+	for(int i = 0; i < data.numRects; i++) {
+		SDL_Rect &a = data.renderRects[0][i];
+		SDL_Rect &b = data.renderRects[1][i];
+		if(a.x != b.x || a.y != b.y || a.w != b.w || a.h != b.h) {
+			return false;
+		}
 	}
+	return true;
+}
 
-	void removeCurrent() {
-		iter--;
-		iter = clamp(iter, 0, numOccupiedTiles-1);
-		playerOccupiedTiles[iter] = playerOccupiedTiles[numOccupiedTiles - 1];
-		playerOccupiedTiles[numOccupiedTiles - 1] = NULL;
-		numOccupiedTiles--;
-	}
+bool benchIntsAgree(BenchData &data) {
+	return memcmp(&data.ints[0][0], &data.ints[1][0], data.numRects * sizeof(int)) == 0;
+}
 
-	void add(Tile* tile) {
-		bool alreadyExists = false;
-		for(int i = 0; i < numOccupiedTiles && !alreadyExists; i++) {
-			alreadyExists = (tile == playerOccupiedTiles[i]);
-		}
-		if(!alreadyExists) {
-			playerOccupiedTiles[numOccupiedTiles++] = tile;
+bool benchWindowsAgree(BenchData &data) {
+	int capacity = data.rectArrays.capacity;
+	for(int row = 0; row < 4; row++) {
+		if(memcmp(&data.windows[0][row*capacity], &data.windows[1][row*capacity], data.numRects * sizeof(int)) != 0) {
+			return false;
 		}
 	}
+	return true;
+}
+
+struct BenchCase {
+	const char *name;
+	void (*runOne)(BenchData &data);   // the game's function, one rect at a time
+	void (*runMany)(BenchData &data);  // collisionBatch.h
+	bool (*agree)(BenchData &data);
+	bool perMover;                     // tests every mover against every rect
 };
 
-void printText(SDL_Texture **texture, SDL_Renderer *renderer, TTF_Font *font, int lineNum, char *fmt, ...)
-{
-	va_list argList;
-	va_start(argList, fmt);
-	vsprintf_s(Text, textLen, fmt, argList);
-	va_end(argList);
+const BenchCase BenchCases[] = {
+	{"xOverlap", benchRectTest<xOverlap>, benchRectTestMany<xOverlapMany>, benchFlagsAgree, true},
+	{"yOverlap", benchRectTest<yOverlap>, benchRectTestMany<yOverlapMany>, benchFlagsAgree, true},
+	{"standingOn", benchRectTest<standingOn>, benchRectTestMany<standingOnMany>, benchFlagsAgree, true},
+	{"isAbove", benchRectTest<isAbove>, benchRectTestMany<isAboveMany>, benchFlagsAgree, true},
+	{"isBelowTop", benchRectTest<isBelowTop>, benchRectTestMany<isBelowTopMany>, benchFlagsAgree, true},
+	{"worldRectToRenderRect", benchRenderRects, benchRenderRectsMany, benchRenderRectsAgree, false},
+	{"clamp", benchClamp, benchClampMany, benchIntsAgree, false},
+	{"OccupiedTiles::add", benchOccupiedTiles, benchOccupiedTileKeys, benchIntsAgree, false},
+	{"collisionWindow", benchCollisionWindow, benchCollisionWindowMany, benchWindowsAgree, false}
+};
+const int NumBenchCases = sizeof(BenchCases) / sizeof(BenchCases[0]);
+
+// fastest of reps runs, in nanoseconds per item
+double timeBench(void (*run)(BenchData &data), BenchData &data, int reps, double numItems) {
+	double best = DBL_MAX;
+	for(int rep = 0; rep < reps; rep++) {
+		Uint64 start = SDL_GetPerformanceCounter();
+		run(data);
+		double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+		best = (seconds < best) ? seconds : best;
+	}
+	return best * 1e9 / numItems;
+}
 
-	if(*texture != NULL) {
-		SDL_DestroyTexture(*texture);
-		*texture = NULL;
+// returns 0 when every batched version agreed with the game's
+int runBench(int argc, char *argv[]) {
+#ifdef _WIN32
+	AttachConsole(ATTACH_PARENT_PROCESS);
+#endif
+	int numRects = clamp((argc > 0) ? atoi(argv[0]) : 1 << 18, 1, 1 << 24);
+	int numReps = max((argc > 1) ? atoi(argv[1]) : 20, 1);
+	Uint32 seed = (argc > 2) ? (Uint32)strtoul(argv[2], NULL, 10) : 1;
+	const char *levelPath = (argc > 3) ? argv[3] : NULL;
+
+	BenchData data;
+	if(!initBenchData(data, numRects, seed, levelPath)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "bench: failed to set up %d rects", numRects);
+		unloadTileMap(data.map);
+		return 1;
 	}
-	SDL_Surface *textSurface = TTF_RenderText_Blended(font, Text, SDL_Color {128, 128, 128, 0});
-	SDL_Rect screenDest;
-	screenDest.x = 0;
-	screenDest.y = textSurface->h * lineNum;
-	screenDest.w = textSurface->w;
-	screenDest.h = textSurface->h;
-	*texture = SDL_CreateTextureFromSurface(renderer, textSurface);
-	SDL_FreeSurface(textSurface);
-	SDL_RenderCopy(renderer, *texture, NULL, &screenDest);
+	SDL_Log("bench: %d rects, %d movers, fastest of %d runs, seed %u, %s (%dx%d tiles)", numRects, NumBenchMovers, numReps, seed,
+		(levelPath != NULL) ? levelPath : "made-up level", data.map.width, data.map.height);
+	SDL_Log("bench: %-22s %22s %22s", "", "one at a time", "batched");
+
+	int numMismatches = 0;
+	for(int c = 0; c < NumBenchCases; c++) {
+		const BenchCase &bench = BenchCases[c];
+		bench.runOne(data);
+		bench.runMany(data);
+		bool agree = bench.agree(data);
+		numMismatches += agree ? 0 : 1;
+
+		double numItems = bench.perMover ? (double)NumBenchMovers * numRects : (double)numRects;
+		double oneNs = timeBench(bench.runOne, data, numReps, numItems);
+		double manyNs = timeBench(bench.runMany, data, numReps, numItems);
+		SDL_Log("bench: %-22s %7.3f ns %8.1f M/s %7.3f ns %8.1f M/s  %5.2fx%s",
+			bench.name, oneNs, 1e3 / oneNs, manyNs, 1e3 / manyNs, oneNs / manyNs, agree ? "" : "  MISMATCH");
+	}
+
+	freeWorldRectArrays(data.rectArrays);
+	unloadTileMap(data.map);
+	return (numMismatches == 0) ? 0 : 2;
 }
 
+// 2dRpg [level.lvl]
 int main(int argc, char *argv[]) {
 
+	if(argc > 1 && strcmp(argv[1], "-soak") == 0) {
+		return runSoak(argc - 2, argv + 2);
+	}
+	if(argc > 1 && strcmp(argv[1], "-bench") == 0) {
+		return runBench(argc - 2, argv + 2);
+	}
+	const char *levelPath = (argc > 1) ? argv[1] : DefaultLevelPath;
+
 	if(SDL_Init(SDL_INIT_EVERYTHING) != 0) {
 		LogError();
 		SDL_Quit();
@@ -323,22 +1506,12 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}
 
-	ScreenProperties screenProps = {};
-	screenProps.screenHeight = 720;
-	screenProps.screenWidth = 1280;
-	float aspectRatio = (float)screenProps.screenWidth / (float)screenProps.screenHeight;
-	float pxPerTile = 16.0f;
-
-	float WorldHeight = 15; 
-	float WorldWidth = WorldHeight * aspectRatio;
-
-
-	screenProps.pixPerVerticalMeter = screenProps.screenHeight / WorldHeight; // pixels per meter
-	screenProps.pixPerHorizontalMeter = screenProps.screenWidth / WorldWidth; // pixels per meter
+	int windowWidth = DefaultScreenWidth;
+	int windowHeight = DefaultScreenHeight;
 
 	SDL_Window *window = SDL_CreateWindow("2D RPG",
 		SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-		screenProps.screenWidth, screenProps.screenHeight,
+		windowWidth, windowHeight,
 		SDL_WindowFlags::SDL_WINDOW_RESIZABLE);
 	if(window == NULL) {
 		LogError();
@@ -367,69 +1540,195 @@ int main(int argc, char *argv[]) {
 	Uint32 msThisFrame = msLastFrame;    // ms
 	float dt = 0.0f; // seconds
 
-	float moveSpeed = 2.68224f; // meters per second
-	float gravity = -9.8f; // meters per second per second
-	float jumpSpeed = 6.0f; // meters per second
-
-	WorldRect player = {};
-	player.x = 0.00f; // meters
-	player.y = 5.00f; // meters
-	player.w = 0.40f; // meters
-	player.h = 1.75f; // meters
+	PlayerBody player;
+	player.rect.x = toWorld(0.00f); // meters
+	player.rect.y = toWorld(5.00f); // meters
+	player.rect.w = toWorld(PlayerWidth);
+	player.rect.h = toWorld(PlayerHeight);
 
-	//vec2 vel(0.0f, 0.0f);
+	TileMap map = {};
+	if(!loadTileMap(map, levelPath, WorldWidth, WorldHeight)) {
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		TTF_Quit();
+		SDL_Quit();
+		return 1;
+	}
 
-	float xVel = 0.0f;
-	float yVel = 0.0f;
+	// the level is baked into one texture and the world drawn into another of the same size,
+	// a level bigger than the renderer's textures can't be shown at all
+	SDL_RendererInfo rendererInfo = {};
+	SDL_GetRendererInfo(renderer, &rendererInfo);
+	int maxTextureWidth = (rendererInfo.max_texture_width > 0) ? rendererInfo.max_texture_width : 16384;
+	int maxTextureHeight = (rendererInfo.max_texture_height > 0) ? rendererInfo.max_texture_height : 16384;
+	if(map.width*map.header->tilePixels > maxTextureWidth || map.height*map.header->tilePixels > maxTextureHeight) {
+		SDL_LogError(SDL_LOG_CATEGORY_RENDER, "%s is %dx%d tiles, %dx%d pixels baked, the renderer's textures are at most %dx%d.",
+			levelPath, map.width, map.height, map.width*map.header->tilePixels, map.height*map.header->tilePixels,
+			maxTextureWidth, maxTextureHeight);
+		unloadTileMap(map);
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		TTF_Quit();
+		SDL_Quit();
+		return 1;
+	}
 
-	PlayerState state = PlayerState::PsInAir;
-	bool dropDown = false;
+	// the world is drawn at tilePixels per tile, like the baked map, into a target of its own
+	// that is scaled to the window in one copy, so resizing only changes where that copy goes
+	// made before anything else is set up, so there's little to free when targets aren't supported
+	int tilePixels = map.header->tilePixels;
+	ScreenProperties screenProps = {};
+	screenProps.screenWidth = map.width*tilePixels;
+	screenProps.screenHeight = map.height*tilePixels;
+	screenProps.pixPerHorizontalMeter = screenProps.screenWidth / WorldWidth; // pixels per meter
+	screenProps.pixPerVerticalMeter = screenProps.screenHeight / WorldHeight; // pixels per meter
+	SDL_Texture *worldTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+		SDL_TEXTUREACCESS_TARGET, screenProps.screenWidth, screenProps.screenHeight);
+	if(worldTexture == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Render targets aren't supported.");
+		LogError();
+		unloadTileMap(map);
+		TTF_CloseFont(font);
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		TTF_Quit();
+		IMG_Quit();
+		SDL_Quit();
+		return 1;
+	}
+	SDL_Rect worldView = worldViewRect(windowWidth, windowHeight, screenProps.screenWidth, screenProps.screenHeight, WorldWidth / WorldHeight);
 
-	TileMap map = {};
-	readTileMapText(map, "..\\res\\TileMap.txt", WorldWidth, WorldHeight);
+	FontAtlas fontAtlas;
+	if(!initFontAtlas(fontAtlas, renderer, font, SDL_Color {128, 128, 128, 0})) {
+		SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Failed to build the font atlas.");
+	}
 
-	SDL_Texture *thisInputTexture = NULL;
-	SDL_Texture *lastInputTexture = NULL;
+	// short-lived memory for this frame: text, render batches
+	FrameArena frameArena;
+	if(!initArena(frameArena, FrameArenaSize)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate the frame arena.");
+	}
+#ifdef TRACK_ALLOCATIONS
+	int frameHeapAllocations = 0;
+	int heapAllocationsAtFrameStart = NumHeapAllocations;
+#endif
 
 	Input input = {};
 
-	OccupiedTiles occupiedTiles;
-
-	SDL_Surface *tiles = IMG_Load("..\\res\\grotto_escape_pack\\graphics\\tiles.png");
-	if(tiles == 0) {
-		SDL_LogError(SDL_LOG_PRIORITY_ERROR, "Failed to load tiles.");
+	float shotSpeed = 20.0f; // meters per second
+	float shotLifetime = 1.5f; // seconds
+	float facing = 1.0f; // -1 left, 1 right
+	ProjectilePool projectiles;
+
+	ParticleSystem particles;
+	int particleCapacities[ParticleNumEmitters] = {};
+	particleCapacities[ParticlesImpact] = 8192;
+	particleCapacities[ParticlesPickup] = 2048;
+	particleCapacities[ParticlesDust] = 131072;
+	particleCapacities[ParticlesDrips] = 4096;
+	if(!initParticles(particles, particleCapacities)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate particles, running without them.");
 	}
 
-	SDL_Texture *tilesTexture = SDL_CreateTextureFromSurface(renderer, tiles);
+	ParticleEmitter &impactEmitter = particles.emitters[ParticlesImpact];
+	impactEmitter.gravityScale = 1.0f;
+	impactEmitter.size = 0.08f;
+	impactEmitter.r = 255;
+	impactEmitter.g = 180;
+	impactEmitter.b = 40;
+
+	ParticleEmitter &pickupEmitter = particles.emitters[ParticlesPickup];
+	pickupEmitter.gravityScale = 0.3f;
+	pickupEmitter.size = 0.08f;
+	pickupEmitter.r = 120;
+	pickupEmitter.g = 220;
+	pickupEmitter.b = 255;
+
+	ParticleEmitter &dustEmitter = particles.emitters[ParticlesDust];
+	dustEmitter.gravityScale = 0.01f;
+	dustEmitter.size = 0.04f;
+	dustEmitter.r = 90;
+	dustEmitter.g = 110;
+	dustEmitter.b = 120;
+
+	ParticleEmitter &dripEmitter = particles.emitters[ParticlesDrips];
+	dripEmitter.gravityScale = 1.0f;
+	dripEmitter.size = 0.05f;
+	dripEmitter.r = 60;
+	dripEmitter.g = 140;
+	dripEmitter.b = 220;
+
+	float dustPerSecond = 150.0f;
+	float dripsPerSecond = 4.0f;
+	float dustToEmit = 0.0f;
+	float dripsToEmit = 0.0f;
+	bool particleStress = false;
+	float particleUpdateMs = 0.0f;
+
+	// lighting: platforms block light, the player carries one
+	Uint8 *opaqueTiles = new Uint8[map.width*map.height];
+	for(int i = 0; i < map.width*map.height; i++) {
+		opaqueTiles[i] = (map.tiles[i] == TileType::TilePlatform);
+	}
+	LightMap lights;
+	initLightMap(lights, map.width, map.height, opaqueTiles);
+	delete[] opaqueTiles;
+
+	Uint8 playerLightLevel = 9;
+	Uint8 torchLightLevel = 12;
+	int playerLight = addLight(lights, (int)(player.rect.x / map.tileWorldWidth), (int)(player.rect.y / map.tileWorldHeight), playerLightLevel);
+	bool drawLighting = true;
+
+	// one texel per tile, upscaled with filtering and multiplied over the scene
+	Uint32 lightColors[MaxLightLevel + 1];
+	for(int level = 0; level <= MaxLightLevel; level++) {
+		float brightness = (float)level / MaxLightLevel;
+		Uint32 r = (Uint32)(24 + brightness * (255 - 24));
+		Uint32 g = (Uint32)(24 + brightness * (240 - 24));
+		Uint32 b = (Uint32)(40 + brightness * (220 - 40));
+		lightColors[level] = 0xFF000000 | (r << 16) | (g << 8) | b;
+	}
+	Uint32 *lightPixels = new Uint32[map.width*map.height];
+	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
+	SDL_Texture *lightTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+		SDL_TEXTUREACCESS_STREAMING, map.width, map.height);
+	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+	SDL_SetTextureBlendMode(lightTexture, SDL_BLENDMODE_MOD);
+
+	// every sprite in one texture, the packed surface is kept until the map is baked from it
+	SpriteAtlas spriteAtlas;
+	SDL_Surface *atlasSurface = NULL;
+	if(!initSpriteAtlas(spriteAtlas, renderer, tilePixels, &atlasSurface)) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to build the sprite atlas.");
+	}
 
 	SDL_Surface *mapSurface = SDL_CreateRGBSurface(
-		0, (int)(map.Width*16), (int)(map.Height*16),
+		0, map.width*tilePixels, map.height*tilePixels,
 		32, 0xFF000000, 0x00FF0000, 0X0000FF00, 0X000000FF);
 
-	int tilesPerRow = 8;
-	int tilesPerColumn = 5;
-
-	SDL_Rect source;
-	source.w = source.h = 16;
-	source.x = source.y = 0;
-
+	// dest rects come precomputed from the compiled level, sources are its tileset tiles in the atlas
 	SDL_Rect dest;
-	dest.w = (int)screenProps.pixPerHorizontalMeter;
-	dest.h = (int)screenProps.pixPerVerticalMeter;
-	dest.x = (int)dest.y = 0;
+	dest.w = dest.h = tilePixels;
 
-	for(int y = 0; y < map.Height; y++) {
-		for(int x = 0; x < map.Width; x++) {
-			source.x = (((int)map.tiles[y][x].type) % tilesPerRow) * 16;
-			source.y = (((int)map.tiles[y][x].type) / tilesPerRow) * 16;
-			dest.x = x * dest.w;
-			dest.y = y * dest.h;
-			SDL_BlitSurface(tiles, &source, mapSurface, &dest);
+	if(mapSurface == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to allocate the %dx%d map surface.", map.width*tilePixels, map.height*tilePixels);
+	}
+	for(int chunkIndex = 0; chunkIndex < map.header->chunksX*map.header->chunksY && atlasSurface != NULL && mapSurface != NULL; chunkIndex++) {
+		const LevelChunk &chunk = map.chunks[chunkIndex];
+		for(Uint32 i = chunk.firstQuad; i < chunk.firstQuad + chunk.numQuads; i++) {
+			const LevelQuad &quad = map.quads[i];
+			SDL_Rect source = atlasTile(spriteAtlas, quad.sourceX, quad.sourceY);
+			dest.x = chunk.pixelX + quad.destX;
+			dest.y = chunk.pixelY + quad.destY;
+			SDL_BlitSurface(atlasSurface, &source, mapSurface, &dest);
 		}
 	}
+	SDL_FreeSurface(atlasSurface);
 
 	SDL_Texture *mapTexture = SDL_CreateTextureFromSurface(renderer, mapSurface);
+	SDL_FreeSurface(mapSurface);
 
+	bool playerFacingLeft = false;
 	bool drawDebug = true;
 	bool drawTileGrid = false;
 	bool shouldBreak = false;
@@ -440,6 +1739,13 @@ int main(int argc, char *argv[]) {
 		msThisFrame = SDL_GetTicks();
 		dt = (msThisFrame - msLastFrame) / 1000.0f;
 
+		// everything allocated from the frame arena last frame is gone now
+		resetArena(frameArena);
+#ifdef TRACK_ALLOCATIONS
+		frameHeapAllocations = NumHeapAllocations - heapAllocationsAtFrameStart;
+		heapAllocationsAtFrameStart = NumHeapAllocations;
+#endif
+
 		// input processing
 		changeFrame(input);
 		SDL_Event e;
@@ -452,10 +1758,9 @@ int main(int argc, char *argv[]) {
 			case SDL_EventType::SDL_WINDOWEVENT:
 				if(e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
 					SDL_Log("Window resized to (%d,%d)", e.window.data1, e.window.data2);
-					screenProps.screenWidth = e.window.data1;
-					screenProps.screenHeight = e.window.data2;
-					screenProps.pixPerHorizontalMeter = screenProps.screenWidth / WorldWidth;
-					screenProps.pixPerVerticalMeter = screenProps.screenHeight / WorldHeight;
+					windowWidth = e.window.data1;
+					windowHeight = e.window.data2;
+					worldView = worldViewRect(windowWidth, windowHeight, screenProps.screenWidth, screenProps.screenHeight, WorldWidth / WorldHeight);
 				}
 				break;
 
@@ -489,6 +1794,10 @@ int main(int argc, char *argv[]) {
 					input.jump.isDown = true;
 					break;
 
+				case SDL_Scancode::SDL_SCANCODE_J:
+					input.attack.isDown = true;
+					break;
+
 				case SDL_Scancode::SDL_SCANCODE_F1:
 					breakHere();
 					break;
@@ -497,9 +1806,49 @@ int main(int argc, char *argv[]) {
 					drawTileGrid = !drawTileGrid;
 					break;
 
+				case SDL_Scancode::SDL_SCANCODE_F3:
+					// crystal pickup burst at the player
+					emitBurst(particles, ParticlesPickup, 40, toMeters(player.rect.x + player.rect.w / 2), toMeters(player.rect.y + player.rect.h / 2),
+						0.0f, 2.0f, 2.0f, 0.8f);
+					break;
+
+				case SDL_Scancode::SDL_SCANCODE_F5:
+					// fill the dust emitter every frame
+					particleStress = !particleStress;
+					break;
+
+				case SDL_Scancode::SDL_SCANCODE_F6: {
+					// place a torch on the player's tile, or take it back
+					int torchX = (int)((player.rect.x + player.rect.w / 2) / map.tileWorldWidth);
+					int torchY = (int)((player.rect.y + player.rect.h / 2) / map.tileWorldHeight);
+					torchX = clamp(torchX, 0, map.width - 1);
+					torchY = clamp(torchY, 0, map.height - 1);
+					bool removedTorch = false;
+					for(int i = 0; i < lights.numSources; i++) {
+						LightSource &source = lights.sources[i];
+						if(i != playerLight && source.isActive && source.x == torchX && source.y == torchY) {
+							removeLight(lights, i);
+							removedTorch = true;
+						}
+					}
+					if(!removedTorch) {
+						addLight(lights, torchX, torchY, torchLightLevel);
+					}
+					break;
+				}
+
+				case SDL_Scancode::SDL_SCANCODE_F7:
+					drawLighting = !drawLighting;
+					break;
+
 				case SDL_Scancode::SDL_SCANCODE_F4:
 					drawDebug = !drawDebug;
 					break;
+
+				case SDL_Scancode::SDL_SCANCODE_F11:
+					// the resize event that follows only moves the world copy
+					SDL_SetWindowFullscreen(window, (SDL_GetWindowFlags(window) & SDL_WINDOW_FULLSCREEN) ? 0 : SDL_WINDOW_FULLSCREEN_DESKTOP);
+					break;
 				}
 				break;
 
@@ -528,6 +1877,10 @@ int main(int argc, char *argv[]) {
 				case SDL_Scancode::SDL_SCANCODE_SPACE:
 					input.jump.isDown = false;
 					break;
+
+				case SDL_Scancode::SDL_SCANCODE_J:
+					input.attack.isDown = false;
+					break;
 				}
 				break;
 			}
@@ -536,242 +1889,94 @@ int main(int argc, char *argv[]) {
 		// emulate joystick values from arrow/WASD keys
 		buildAnalogInput(input);
 
-		// process input based on player state
-		switch(state) {
-		case PlayerState::PsInAir:
-			xVel = input.stick.endX * moveSpeed;
-			yVel += gravity * dt;
-			break;
+		// move the player and collide with tiles
+		tickPlayer(player, input, map, dt);
 
-		case PlayerState::PsOnLadder:
-			if(input.jump.isDown && !input.jump.wasDown) {
-				state = PlayerState::PsInAir;
-				dropDown = true;
-				xVel = input.stick.endX * moveSpeed;
-				yVel += jumpSpeed / 3;
-			} else {
-				xVel = 0;
-				yVel = input.stick.endY * moveSpeed;
+		// shoot
+		if(input.stick.endX != 0) {
+			facing = (input.stick.endX > 0) ? 1.0f : -1.0f;
+		}
+		if(input.attack.isDown && !input.attack.wasDown) {
+			Projectile *shot = projectiles.spawn();
+			if(shot != NULL) {
+				shot->x = toMeters(player.rect.x + player.rect.w / 2);
+				shot->y = toMeters(player.rect.y) + toMeters(player.rect.h) * 0.6f;
+				shot->xVel = facing * shotSpeed;
+				shot->yVel = 0.0f;
+				shot->timeLeft = shotLifetime;
 			}
-			break;
+		}
 
-		case PlayerState::PsOnTransientGround:
-			xVel = input.stick.endX * moveSpeed;
-			if(input.stick.endY < 0 && input.stick.startY != input.stick.endY) {
-				dropDown = true;
-				state = PlayerState::PsInAir;
-				yVel -= moveSpeed;
-			} else if(input.jump.isDown && !input.jump.wasDown) {
-				// jump
-				state = PlayerState::PsInAir;
-				yVel += jumpSpeed;
+		// move projectiles, sweeping each one's path for this frame through the tile grid
+		for(int i = 0; i < projectiles.numProjectiles;) {
+			Projectile &shot = projectiles.projectiles[i];
+			float deltaX = shot.xVel * dt;
+			float deltaY = shot.yVel * dt;
+			float hitT;
+			shot.timeLeft -= dt;
+			if(shot.timeLeft <= 0.0f) {
+				projectiles.despawn(i);
+				continue;
 			}
-			break;
-
-		case PlayerState::PsPsOnSolidGround:
-			xVel = input.stick.endX * moveSpeed;
-			if(input.jump.isDown && !input.jump.wasDown) {
-				// jump
-				state = PlayerState::PsInAir;
-				yVel += jumpSpeed;
+			if(raycastTiles(map, shot.x, shot.y, deltaX, deltaY, hitT)) {
+				emitBurst(particles, ParticlesImpact, 16, shot.x + deltaX * hitT, shot.y + deltaY * hitT,
+					-shot.xVel * 0.1f, 1.0f, 2.5f, 0.4f);
+				projectiles.despawn(i);
+				continue;
 			}
-			break;
-		}
-
-		// move player
-		WorldRect playerPosCopy = player;
-
-		// move x
-		player.x += xVel * dt;
-		if(player.x < 0) {
-			player.x = 0;
-			xVel = 0;
-		} else if(player.x + player.w > WorldWidth) {
-			player.x = WorldWidth - player.w;
-			xVel = 0;
-		}
-
-		// move y
-		player.y += yVel * dt;
-		if(player.y <= 0) {
-			player.y = 0;
-			yVel = 0;
-			state = PlayerState::PsPsOnSolidGround;
-		} else if(player.y + player.h > WorldHeight) {
-			player.y = WorldHeight - player.h;
-			yVel = 0;
-			state = PlayerState::PsInAir;
-		}
-
-		// check previously collided tiles
-		bool isOnTransientGround = false;
-		bool isOnLadder = false;
-		while(occupiedTiles.hasNext()) {
-			Tile *tile = occupiedTiles.next();
-			WorldRect wRect = {tile->xPos, tile->yPos, tile->common->hitboxWidth, tile->common->hitboxHeight};
-
-			switch(tile->type) {
-			case TileType::TileNone:
-				break;
-
-			case TileType::TilePlatform:
-				// if the player was on a platform, and the player is on this platform...
-				// then the player is still on a platform
-				if(state == PlayerState::PsOnTransientGround) {
-					if(xOverlap(player, wRect) && standingOn(player, wRect)) {
-						isOnTransientGround = true;
-					} else {
-						occupiedTiles.removeCurrent();
-						break;
-					}
-				} 
-				break;
-
-			case TileType::TileLadder:
-				if(state == PlayerState::PsOnLadder) {
-					if(!dropDown &&  xOverlap(player, wRect) && yOverlap(player, wRect)) {
-						isOnLadder = true;
-					} else {
-						occupiedTiles.removeCurrent();
-						break;
-					}
-				// else if the player was on a ladder top, and the player is on this ladder top...
-				// then the player is still on this ladder top
-				} else if(state == PlayerState::PsOnTransientGround) {
-					if(xOverlap(player, wRect)) {
-						isOnTransientGround = true;
-					} else {
-						occupiedTiles.removeCurrent();
-						break;
-					}
-				}
-				break;
+			shot.x += deltaX;
+			shot.y += deltaY;
+			if(shot.x < 0 || shot.x > WorldWidth || shot.y < 0 || shot.y > WorldHeight) {
+				projectiles.despawn(i);
+				continue;
 			}
+			i++;
 		}
 
-		// process post tile collision 
-		if(state == PlayerState::PsOnLadder && !isOnLadder) {
-			state = PlayerState::PsOnTransientGround;
-			yVel = 0;
-		} else if((state == PlayerState::PsOnLadder && !isOnLadder) ||
-			(state == PlayerState::PsOnTransientGround && !isOnTransientGround)) {
-			state = PlayerState::PsInAir;
+		// ambient particles: dust anywhere, drips from the underside of platforms
+		dustToEmit += (particleStress ? (float)dustEmitter.capacity : dustPerSecond * dt);
+		int numDust = min((int)dustToEmit, dustEmitter.capacity - dustEmitter.count);
+		dustToEmit -= (int)dustToEmit;
+		for(int i = 0; i < numDust; i++) {
+			emitParticle(particles, ParticlesDust,
+				particleRandom(particles, 0.0f, WorldWidth), particleRandom(particles, 0.0f, WorldHeight),
+				particleRandom(particles, -0.1f, 0.1f), particleRandom(particles, -0.05f, 0.05f),
+				particleRandom(particles, 3.0f, 8.0f));
 		}
-
-		isOnLadder = false;
-		isOnTransientGround = false;
-
-		// check current tile collisions
-		int numCollidedTiles = 0;
-		int minTileX = (int)(player.x / map.tileWidth) - 1;
-		int maxTileX = (int)((player.x + player.w) / map.tileWidth) + 2;
-		int minTileY = (int)(player.y / map.tileHeight) - 1;
-		int maxTileY = (int)((player.y + player.h) / map.tileHeight) + 2;
-
-		maxTileX = min(maxTileX, map.Width);
-		maxTileY = min(maxTileY, map.Height);
-		minTileX = max(minTileX, 0);
-		minTileY = max(minTileY, 0);
-
-		for(int tileY = minTileY; tileY < maxTileY; tileY++) {
-			for(int tileX = minTileX; tileX < maxTileX; tileX++) {
-				Tile *tile = &map.tiles[tileY][tileX];
-				WorldRect wRect = {tile->xPos, tile->yPos, tile->common->hitboxWidth, tile->common->hitboxHeight};
-
-				switch(tile->type) {
-				case TileType::TileNone:
-					break;
-
-				case TileType::TilePlatform:
-					// if the player was in the air, and was above platform, and is now under top layer...
-					// then player is on the platform
-					if(state == PlayerState::PsInAir) {
-						if(!dropDown &&
-							isAbove(playerPosCopy, wRect) && xOverlap(playerPosCopy, wRect) &&
-							isBelowTop(player, wRect) && xOverlap(player, wRect)) {
-							// land on platform
-							state = PlayerState::PsOnTransientGround;
-							yVel = 0;
-							player.y = tile->yPos + tile->common->hitboxHeight;
-							occupiedTiles.add(tile);
-						}
-
-						// if the player was going down a ladder and is now on this platform...
-						// then the player is now on this platform
-					} else if(state == PlayerState::PsOnLadder) {
-						if(yVel < 0 && xOverlap(player, wRect) && isBelowTop(player, wRect)) {
-							// land on platform
-							state = PlayerState::PsOnTransientGround;
-							yVel = 0;
-							player.y = tile->yPos + tile->common->hitboxHeight;
-							occupiedTiles.add(tile);
-						}
-					}
-					break;
-
-				case TileType::TileLadder:
-					// if the player is on a ladder, and is vertically on this ladder...
-					// then the player is still on this ladder
-					if(state == PlayerState::PsOnLadder) {
-						if(!dropDown && xOverlap(player, wRect) &&
-							!yOverlap(playerPosCopy, wRect) && yOverlap(player, wRect)) {
-
-							occupiedTiles.add(tile);
-						}
-					} else {
-
-						// if the player was not on a ladder, and the player presses up or down,
-						// and the player is overlapping this ladder...
-						// then the player is now on this ladder
-						if(/*!dropDown &&*/ input.stick.startY != input.stick.endY &&
-							(input.stick.endY > 0 || input.stick.endY < 0)) {
-							if(xOverlap(player, wRect) && yOverlap(player, wRect)) {
-								isOnLadder = true;
-								xVel = 0;
-								yVel = 0;
-								player.x = tile->xPos + (tile->common->hitboxWidth - player.w) / 2;
-								occupiedTiles.add(tile);
-							}
-						}
-
-						// if the player was in the air, and was above platform, and is now under top layer,
-						// and this ladder is not below another ladder...
-						// then player is on the ladder top
-						if(state == PlayerState::PsInAir) {
-							bool ladderHasNoLadderAboveIt = true;
-							if(tileY < (maxTileY - 1)) {
-								if(map.tiles[tileY + 1][tileX].type == TileType::TileLadder) {
-									ladderHasNoLadderAboveIt = false;
-								}
-							}
-							if(!dropDown && ladderHasNoLadderAboveIt &&
-								isAbove(playerPosCopy, wRect) && xOverlap(playerPosCopy, wRect) &&
-								isBelowTop(player, wRect) && xOverlap(player, wRect)) {
-								// land on platform
-								state = PlayerState::PsOnTransientGround;
-								yVel = 0;
-								player.y = tile->yPos + tile->common->hitboxHeight; 
-								occupiedTiles.add(tile);
-							}
-						}
-
-					}
-					break;
-				}
+		dripsToEmit += dripsPerSecond * dt;
+		for(; dripsToEmit >= 1.0f; dripsToEmit -= 1.0f) {
+			int tileX = (int)particleRandom(particles, 0.0f, (float)map.width);
+			int tileY = (int)particleRandom(particles, 1.0f, (float)map.height);
+			tileX = clamp(tileX, 0, map.width - 1);
+			tileY = clamp(tileY, 1, map.height - 1);
+			if(getTileType(map, tileX, tileY) == TileType::TilePlatform &&
+				getTileType(map, tileX, tileY - 1) == TileType::TileNone) {
+				emitParticle(particles, ParticlesDrips,
+					(tileX + particleRandom(particles, 0.2f, 0.8f)) * map.tileWidth, tileY * map.tileHeight,
+					0.0f, 0.0f, 2.0f);
 			}
 		}
 
-		if(isOnLadder) {
-			state = PlayerState::PsOnLadder;
-		}
-		dropDown = false;
+		// only relights when the player crosses into another tile
+		moveLight(lights, playerLight,
+			(int)((player.rect.x + player.rect.w / 2) / map.tileWorldWidth), (int)((player.rect.y + player.rect.h / 2) / map.tileWorldHeight));
+
+		Uint64 particleStart = SDL_GetPerformanceCounter();
+		updateParticles(particles, Gravity, dt);
+		particleUpdateMs = (SDL_GetPerformanceCounter() - particleStart) * 1000.0f / SDL_GetPerformanceFrequency();
 
-		WorldRect collideRect = {(float)minTileX, (float)minTileY, (float)maxTileX - minTileX, (float)maxTileY - minTileY};
+		int minTileX, minTileY, maxTileX, maxTileY;
+		collisionWindow(map, player.rect, minTileX, minTileY, maxTileX, maxTileY);
+		WorldRect collideRect = {
+			minTileX*map.tileWorldWidth, minTileY*map.tileWorldHeight,
+			(maxTileX - minTileX)*map.tileWorldWidth, (maxTileY - minTileY)*map.tileWorldHeight
+		};
 
 
 // Rendering
 
-		// clear screen
+		// world first, into its own target
+		SDL_SetRenderTarget(renderer, worldTexture);
 		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
 		SDL_RenderClear(renderer);
 
@@ -786,8 +1991,8 @@ int main(int argc, char *argv[]) {
 		//tile map
 		SDL_RenderCopy(renderer, mapTexture, NULL, NULL);
 		WorldRect worldDest = {};
-		//for(int y = 0; y < TileMap::Height; y++) {
-		//	for(int x = 0; x < TileMap::Width; x++) {
+		//for(int y = 0; y < map.height; y++) {
+		//	for(int x = 0; x < map.width; x++) {
 		//		worldDest = {
 		//			map.tiles[y][x].xPos,
 		//			map.tiles[y][x].yPos,
@@ -810,27 +2015,108 @@ int main(int argc, char *argv[]) {
 		//	}
 		//}
 
-		//draw player
-		worldRectToRenderRect(player, screenDest, screenProps);
-		SDL_SetRenderDrawColor(renderer, 128, 128, 128, 255);
-		SDL_RenderFillRect(renderer, &screenDest);
+		//draw player, a square sprite standing on the bottom of the hitbox
+		if(player.xVel != 0.0f) {
+			playerFacingLeft = player.xVel < 0.0f;
+		}
+		SpriteId playerSprite = SpritePlayerRun;
+		int playerFrame = 0;
+		switch(player.state) {
+		case PlayerState::PsInAir:
+			playerSprite = SpritePlayerJump;
+			break;
+		case PlayerState::PsOnLadder:
+			playerSprite = SpritePlayerClimb;
+			playerFrame = (int)(toMeters(player.rect.y) * 4.0f);
+			break;
+		default:
+			playerFrame = (player.xVel != 0.0f) ? (int)(msThisFrame / 100) : 0;
+			break;
+		}
+		WorldRect spriteRect = {player.rect.x + player.rect.w / 2 - player.rect.h / 2, player.rect.y, player.rect.h, player.rect.h};
+		worldRectToRenderRect(spriteRect, screenDest, screenProps);
+		SDL_RenderCopyEx(renderer, spriteAtlas.texture, &spriteFrame(spriteAtlas, playerSprite, playerFrame), &screenDest,
+			0.0, NULL, playerFacingLeft ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE);
+		if(drawDebug) {
+			worldRectToRenderRect(player.rect, screenDest, screenProps);
+			SDL_SetRenderDrawColor(renderer, 128, 128, 128, 255);
+			SDL_RenderDrawRect(renderer, &screenDest);
+		}
+
+		//draw particles, one batch per emitter
+		for(int e = 0; e < ParticleNumEmitters; e++) {
+			ParticleEmitter &emitter = particles.emitters[e];
+			int sizeX = max((int)(emitter.size * screenProps.pixPerHorizontalMeter), 1);
+			int sizeY = max((int)(emitter.size * screenProps.pixPerVerticalMeter), 1);
+			SDL_Rect *particleRects = arenaAllocArray<SDL_Rect>(frameArena, emitter.count);
+			if(particleRects == NULL) {
+				continue;
+			}
+			for(int i = 0; i < emitter.count; i++) {
+				SDL_Rect &rect = particleRects[i];
+				rect.x = (int)(particles.x[emitter.first + i] * screenProps.pixPerHorizontalMeter) - sizeX / 2;
+				rect.y = screenProps.screenHeight - (int)(particles.y[emitter.first + i] * screenProps.pixPerVerticalMeter) - sizeY / 2;
+				rect.w = sizeX;
+				rect.h = sizeY;
+			}
+			SDL_SetRenderDrawColor(renderer, emitter.r, emitter.g, emitter.b, 255);
+			SDL_RenderFillRects(renderer, particleRects, emitter.count);
+		}
+
+		//draw projectiles, in one batch
+		SDL_Rect *shotRects = arenaAllocArray<SDL_Rect>(frameArena, projectiles.numProjectiles);
+		for(int i = 0; i < projectiles.numProjectiles && shotRects != NULL; i++) {
+			WorldRect shotRect = worldRectFromMeters(projectiles.projectiles[i].x - 0.15f, projectiles.projectiles[i].y - 0.05f, 0.3f, 0.1f);
+			worldRectToRenderRect(shotRect, shotRects[i], screenProps);
+		}
+		SDL_SetRenderDrawColor(renderer, 255, 160, 0, 255);
+		if(shotRects != NULL) {
+			SDL_RenderFillRects(renderer, shotRects, projectiles.numProjectiles);
+		}
+
+		//draw lighting, uploading only the tiles that changed
+		if(isLightDirty(lights)) {
+			for(int y = lights.dirtyMinY; y <= lights.dirtyMaxY; y++) {
+				int row = (map.height - 1) - y;
+				for(int x = lights.dirtyMinX; x <= lights.dirtyMaxX; x++) {
+					lightPixels[row*map.width + x] = lightColors[lights.light[y*map.width + x]];
+				}
+			}
+			SDL_Rect dirtyRect;
+			dirtyRect.x = lights.dirtyMinX;
+			dirtyRect.y = (map.height - 1) - lights.dirtyMaxY;
+			dirtyRect.w = lights.dirtyMaxX - lights.dirtyMinX + 1;
+			dirtyRect.h = lights.dirtyMaxY - lights.dirtyMinY + 1;
+			SDL_UpdateTexture(lightTexture, &dirtyRect,
+				&lightPixels[dirtyRect.y*map.width + dirtyRect.x], map.width * (int)sizeof(Uint32));
+			clearLightDirty(lights);
+		}
+		if(drawLighting) {
+			SDL_RenderCopy(renderer, lightTexture, NULL, NULL);
+		}
 
 		//draw tile grid
 		if(drawTileGrid) {
 			SDL_SetRenderDrawColor(renderer, 0, 128, 0, 255);
-			for(int y = 0; y < map.Height; y++) {
-				for(int x = 0; x < map.Width; x++) {
-					WorldRect rect = {x*map.tileWidth, y*map.tileHeight, map.tileWidth, map.tileHeight};
+			for(int y = 0; y < map.height; y++) {
+				for(int x = 0; x < map.width; x++) {
+					WorldRect rect = {x*map.tileWorldWidth, y*map.tileWorldHeight, map.tileWorldWidth, map.tileWorldHeight};
 					worldRectToRenderRect(rect, screenDest, screenProps);
 					SDL_RenderDrawRect(renderer, &screenDest);
 				}
 			}
 		}
 
+		// then the world scaled to the window, and the HUD on top at the window's own resolution
+		SDL_SetRenderTarget(renderer, NULL);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+		SDL_RenderClear(renderer);
+		SDL_RenderCopy(renderer, worldTexture, NULL, &worldView);
+
 		if(drawDebug) {
 
 			//render new input
-			printText(&thisInputTexture, renderer, font, 0, 
+			printText(frameArena, renderer, fontAtlas, 0, 
 				"NewInput: {Up: %d} {Down: %d} {Left: %d} {Right: %d} {Jump: %d}",
 				input.arrowUp.isDown,
 				input.arrowDown.isDown,
@@ -840,7 +2126,7 @@ int main(int argc, char *argv[]) {
 
 
 			//render delta input
-			printText(&thisInputTexture, renderer, font, 1,
+			printText(frameArena, renderer, fontAtlas, 1,
 				"Delta   : {Up: %d} {Down: %d} {Left: %d} {Right: %d} {Jump: %d}",
 				input.arrowUp.isDown != input.arrowUp.wasDown,
 				input.arrowDown.isDown != input.arrowDown.wasDown,
@@ -851,20 +2137,20 @@ int main(int argc, char *argv[]) {
 			//render mouse position text
 			int mouseX, mouseY;
 			SDL_GetMouseState(&mouseX, &mouseY);
-			printText(&thisInputTexture, renderer, font, 2,
+			printText(frameArena, renderer, fontAtlas, 2,
 				"WorldMouse: {%f,%f}  ScreenMouse: {%d,%d}",
-				mouseX / screenProps.pixPerHorizontalMeter,
-				mouseY / screenProps.pixPerVerticalMeter,
+				(mouseX - worldView.x) * WorldWidth / worldView.w,
+				(worldView.y + worldView.h - mouseY) * WorldHeight / worldView.h,
 				mouseX, mouseY);
 
 			//render player pos
-			printText(&thisInputTexture, renderer, font, 3,
+			printText(frameArena, renderer, fontAtlas, 3,
 				"PlayerPos: {%f, %f} PlayerVel: {%f, %f}", 
-				player.x, player.y, xVel, yVel);
+				toMeters(player.rect.x), toMeters(player.rect.y), player.xVel, player.yVel);
 
 			//render player state
 			char *target = "PlayerState: Unknown State";
-			switch(state) {
+			switch(player.state) {
 			case PlayerState::PsInAir:
 				target = "PlayerState: inAir";
 				break;
@@ -878,7 +2164,28 @@ int main(int argc, char *argv[]) {
 				target = "PlayerState: onSolidGround";
 				break;
 			}
-			printText(&thisInputTexture, renderer, font, 4, target);
+			printText(frameArena, renderer, fontAtlas, 4, target);
+
+			//render projectile count
+			printText(frameArena, renderer, fontAtlas, 5,
+				"Projectiles: %d/%d", projectiles.numProjectiles, ProjectilePool::MaxNumProjectiles);
+
+			//render particle count
+			printText(frameArena, renderer, fontAtlas, 6,
+				"Particles: %d/%d  update: %.3f ms", numLiveParticles(particles), particles.capacity, particleUpdateMs);
+
+			//render memory use, the heap count is for the whole previous frame
+#ifdef TRACK_ALLOCATIONS
+			printText(frameArena, renderer, fontAtlas, 7,
+				"Heap allocs last frame: %d  frame arena: %d/%d KB, peak %d KB, %d failed",
+				frameHeapAllocations, (int)(frameArena.used >> 10), (int)(frameArena.capacity >> 10),
+				(int)(frameArena.peak >> 10), frameArena.numFailed);
+#else
+			printText(frameArena, renderer, fontAtlas, 7,
+				"Heap allocs: not tracked  frame arena: %d/%d KB, peak %d KB, %d failed",
+				(int)(frameArena.used >> 10), (int)(frameArena.capacity >> 10),
+				(int)(frameArena.peak >> 10), frameArena.numFailed);
+#endif
 
 		} // if(drawDebug)
 
@@ -891,6 +2198,17 @@ int main(int argc, char *argv[]) {
 		// post-frame timing
 		msLastFrame = msThisFrame;
 	}
+	SDL_DestroyTexture(worldTexture);
+	SDL_DestroyTexture(mapTexture);
+	SDL_DestroyTexture(lightTexture);
+	delete[] lightPixels;
+	freeLightMap(lights);
+	freeParticles(particles);
+	unloadTileMap(map);
+	freeArena(frameArena);
+	freeFontAtlas(fontAtlas);
+	freeSpriteAtlas(spriteAtlas);
+	TTF_CloseFont(font);
 	SDL_DestroyRenderer(renderer);
 	SDL_DestroyWindow(window);
 	TTF_Quit();
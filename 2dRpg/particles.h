@@ -0,0 +1,201 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <xmmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+// particles are stored as separate float arrays (x, y, xVel, yVel, life) so the update
+// runs on whole SSE/AVX registers; each emitter owns a fixed slice of those arrays
+
+#ifdef __AVX__
+const int ParticleLanes = 8;
+#else
+const int ParticleLanes = 4;
+#endif
+
+enum ParticleEmitterType {
+	ParticlesImpact,
+	ParticlesPickup,
+	ParticlesDust,
+	ParticlesDrips,
+	ParticleNumEmitters
+};
+
+struct ParticleEmitter {
+	int first = 0;             // slice of the particle arrays, [first, first + capacity)
+	int capacity = 0;
+	int count = 0;             // live particles, packed at the front of the slice
+	float gravityScale = 1.0f;
+	float size = 0.1f;         // meters
+	uint8_t r = 255;
+	uint8_t g = 255;
+	uint8_t b = 255;
+};
+
+struct ParticleSystem {
+	int capacity = 0;
+	float *memory = NULL;
+	float *x = NULL;     // meters
+	float *y = NULL;     // meters
+	float *xVel = NULL;  // meters per second
+	float *yVel = NULL;  // meters per second
+	float *life = NULL;  // seconds left
+	ParticleEmitter emitters[ParticleNumEmitters];
+	uint32_t randomState = 0x9E3779B9;
+};
+
+inline int particleRoundUp(int count) {
+	return (count + ParticleLanes - 1) / ParticleLanes * ParticleLanes;
+}
+
+// allocates every emitter's slice up front, nothing is allocated after this
+inline bool initParticles(ParticleSystem &ps, const int capacities[ParticleNumEmitters]) {
+	int total = 0;
+	for(int i = 0; i < ParticleNumEmitters; i++) {
+		ps.emitters[i].first = total;
+		ps.emitters[i].capacity = particleRoundUp(capacities[i]);
+		ps.emitters[i].count = 0;
+		total += ps.emitters[i].capacity;
+	}
+
+	ps.memory = (float *)_mm_malloc(5 * total * sizeof(float), 32);
+	if(ps.memory == NULL) {
+		// no slices at all, so every emit is refused instead of writing through the NULL arrays
+		for(int i = 0; i < ParticleNumEmitters; i++) {
+			ps.emitters[i].first = ps.emitters[i].capacity = ps.emitters[i].count = 0;
+		}
+		ps.capacity = 0;
+		return false;
+	}
+	memset(ps.memory, 0, 5 * total * sizeof(float));
+	ps.capacity = total;
+	ps.x = ps.memory;
+	ps.y = ps.x + total;
+	ps.xVel = ps.y + total;
+	ps.yVel = ps.xVel + total;
+	ps.life = ps.yVel + total;
+	return true;
+}
+
+inline void freeParticles(ParticleSystem &ps) {
+	_mm_free(ps.memory);
+	ps.memory = ps.x = ps.y = ps.xVel = ps.yVel = ps.life = NULL;
+	ps.capacity = 0;
+}
+
+inline float particleRandom(ParticleSystem &ps, float min, float max) {
+	// xorshift32
+	uint32_t x = ps.randomState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	ps.randomState = x;
+	return min + (max - min) * ((x >> 8) * (1.0f / 16777216.0f));
+}
+
+// returns false when the emitter's slice is full
+inline bool emitParticle(ParticleSystem &ps, ParticleEmitterType type, float x, float y, float xVel, float yVel, float life) {
+	ParticleEmitter &emitter = ps.emitters[type];
+	if(emitter.count == emitter.capacity) {
+		return false;
+	}
+	int i = emitter.first + emitter.count++;
+	ps.x[i] = x;
+	ps.y[i] = y;
+	ps.xVel[i] = xVel;
+	ps.yVel[i] = yVel;
+	ps.life[i] = life;
+	return true;
+}
+
+// sprays count particles out of a point
+inline void emitBurst(ParticleSystem &ps, ParticleEmitterType type, int count, float x, float y,
+	float xVel, float yVel, float spread, float life) {
+	for(int i = 0; i < count; i++) {
+		float particleLife = life * particleRandom(ps, 0.5f, 1.0f);
+		if(!emitParticle(ps, type, x, y,
+			xVel + particleRandom(ps, -spread, spread),
+			yVel + particleRandom(ps, -spread, spread),
+			particleLife)) {
+			break;
+		}
+	}
+}
+
+// vel += gravity*dt, pos += vel*dt, life -= dt for [begin, end)
+// begin is lane aligned and slices are padded to whole lanes, so the last partial register is safe
+inline void integrateParticles(ParticleSystem &ps, int begin, int end, float gravity, float dt) {
+	int i = begin;
+#ifdef __AVX__
+	__m256 gravityDt8 = _mm256_set1_ps(gravity * dt);
+	__m256 dt8 = _mm256_set1_ps(dt);
+	for(; i < end; i += 8) {
+		__m256 xVel = _mm256_load_ps(ps.xVel + i);
+		__m256 yVel = _mm256_add_ps(_mm256_load_ps(ps.yVel + i), gravityDt8);
+		_mm256_store_ps(ps.yVel + i, yVel);
+		_mm256_store_ps(ps.x + i, _mm256_add_ps(_mm256_load_ps(ps.x + i), _mm256_mul_ps(xVel, dt8)));
+		_mm256_store_ps(ps.y + i, _mm256_add_ps(_mm256_load_ps(ps.y + i), _mm256_mul_ps(yVel, dt8)));
+		_mm256_store_ps(ps.life + i, _mm256_sub_ps(_mm256_load_ps(ps.life + i), dt8));
+	}
+#else
+	__m128 gravityDt4 = _mm_set1_ps(gravity * dt);
+	__m128 dt4 = _mm_set1_ps(dt);
+	for(; i < end; i += 4) {
+		__m128 xVel = _mm_load_ps(ps.xVel + i);
+		__m128 yVel = _mm_add_ps(_mm_load_ps(ps.yVel + i), gravityDt4);
+		_mm_store_ps(ps.yVel + i, yVel);
+		_mm_store_ps(ps.x + i, _mm_add_ps(_mm_load_ps(ps.x + i), _mm_mul_ps(xVel, dt4)));
+		_mm_store_ps(ps.y + i, _mm_add_ps(_mm_load_ps(ps.y + i), _mm_mul_ps(yVel, dt4)));
+		_mm_store_ps(ps.life + i, _mm_sub_ps(_mm_load_ps(ps.life + i), dt4));
+	}
+#endif
+}
+
+// true if any particle in the lane-aligned group at i is dead
+inline bool anyParticleDead(ParticleSystem &ps, int i) {
+#ifdef __AVX__
+	return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_load_ps(ps.life + i), _mm256_setzero_ps(), _CMP_LE_OQ)) != 0;
+#else
+	return _mm_movemask_ps(_mm_cmple_ps(_mm_load_ps(ps.life + i), _mm_setzero_ps())) != 0;
+#endif
+}
+
+// removes dead particles by moving the last live one of the slice into their place
+// groups with nothing dead are skipped a whole register at a time
+inline void cullParticles(ParticleSystem &ps, ParticleEmitter &emitter) {
+	int i = emitter.first;
+	int end = emitter.first + emitter.count;
+	while(i < end) {
+		if(((i - emitter.first) % ParticleLanes) == 0 && i + ParticleLanes <= end && !anyParticleDead(ps, i)) {
+			i += ParticleLanes;
+		} else if(ps.life[i] <= 0.0f) {
+			end--;
+			ps.x[i] = ps.x[end];
+			ps.y[i] = ps.y[end];
+			ps.xVel[i] = ps.xVel[end];
+			ps.yVel[i] = ps.yVel[end];
+			ps.life[i] = ps.life[end];
+		} else {
+			i++;
+		}
+	}
+	emitter.count = end - emitter.first;
+}
+
+inline void updateParticles(ParticleSystem &ps, float gravity, float dt) {
+	for(int e = 0; e < ParticleNumEmitters; e++) {
+		ParticleEmitter &emitter = ps.emitters[e];
+		integrateParticles(ps, emitter.first, emitter.first + emitter.count, gravity * emitter.gravityScale, dt);
+		cullParticles(ps, emitter);
+	}
+}
+
+inline int numLiveParticles(ParticleSystem &ps) {
+	int count = 0;
+	for(int e = 0; e < ParticleNumEmitters; e++) {
+		count += ps.emitters[e].count;
+	}
+	return count;
+}
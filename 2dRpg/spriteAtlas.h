@@ -0,0 +1,263 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_image.h>
+
+// every sheet of the grotto escape pack, packed at load time into one texture so the whole scene
+// draws without switching textures
+// frames are packed one by one with their edge pixels repeated out over the padding, so scaled or filtered
+// drawing never picks up the frame next to them
+
+enum SpriteSheet {
+	SheetTiles,
+	SheetEnemies,
+	SheetItems,
+	SheetPlayer,
+	SheetMeter,
+	NumSpriteSheets
+};
+
+const char *const SpriteSheetFiles[NumSpriteSheets] = {
+	"..\\res\\grotto_escape_pack\\graphics\\tiles.png",
+	"..\\res\\grotto_escape_pack\\graphics\\enemies.png",
+	"..\\res\\grotto_escape_pack\\graphics\\items.png",
+	"..\\res\\grotto_escape_pack\\graphics\\player.png",
+	"..\\res\\grotto_escape_pack\\graphics\\meter.png"
+};
+
+enum SpriteId {
+	SpritePlayerRun,
+	SpritePlayerJump,
+	SpritePlayerClimb,
+	SpritePlayerDuck,
+	SpriteSlime,
+	SpriteLizard,
+	SpriteEye,
+	SpritePowerup,
+	SpriteBattery,
+	SpriteCrystal,
+	SpriteShot,
+	SpriteOrb,
+	SpriteJars,         // one frame per kind: boots, heart, lock, bomb
+	SpriteHealthMeter,  // one frame per pip, 1 to 6
+	NumSprites
+};
+
+// where a sprite's frames are in its sheet, frame i is at (x + i*stepX, y + i*stepY)
+struct SpriteRegion {
+	SpriteSheet sheet;
+	int x;
+	int y;
+	int w;
+	int h;
+	int numFrames;
+	int stepX;
+	int stepY;
+};
+
+const SpriteRegion SpriteRegions[NumSprites] = {
+	{SheetPlayer,   0,  0, 16, 16, 4, 16, 0},  // SpritePlayerRun
+	{SheetPlayer,   0, 16, 16, 16, 1, 16, 0},  // SpritePlayerJump
+	{SheetPlayer,  16, 16, 16, 16, 2, 16, 0},  // SpritePlayerClimb
+	{SheetPlayer,  48, 16, 16, 16, 1, 16, 0},  // SpritePlayerDuck
+	{SheetEnemies,  0,  0, 16, 16, 3, 16, 0},  // SpriteSlime
+	{SheetEnemies,  0, 16, 16, 16, 4, 16, 0},  // SpriteLizard
+	{SheetEnemies,  0, 32, 16, 16, 3, 16, 0},  // SpriteEye
+	{SheetItems,    0,  0, 16, 16, 3, 16, 0},  // SpritePowerup
+	{SheetItems,   48,  0, 16, 16, 1, 16, 0},  // SpriteBattery
+	{SheetItems,    0, 16, 16, 16, 4, 16, 0},  // SpriteCrystal
+	{SheetItems,    0, 32, 16, 16, 3, 16, 0},  // SpriteShot
+	{SheetItems,   48, 32, 16, 16, 1, 16, 0},  // SpriteOrb
+	{SheetItems,    0, 48, 16, 16, 4, 16, 0},  // SpriteJars
+	{SheetMeter,    0,  0, 28,  7, 6, 0,  7}   // SpriteHealthMeter
+};
+
+const int MaxAtlasTiles = 256;
+const int MaxSpriteFrames = 128;
+const int AtlasWidth = 256;    // pixels, the height is whatever the shelves need
+const int AtlasPadding = 1;    // extruded pixels around every frame
+
+struct SpriteAtlas {
+	SDL_Texture *texture = NULL;
+	int width = 0;
+	int height = 0;
+
+	// tiles.png is cut into tilePixels squares, [row*tilesPerRow + column]
+	int tilePixels = 0;
+	int tilesPerRow = 0;
+	int tilesPerColumn = 0;
+	SDL_Rect tiles[MaxAtlasTiles];
+
+	// frames of every SpriteId, each sprite's frames are consecutive
+	SDL_Rect frames[MaxSpriteFrames];
+	int firstFrame[NumSprites];
+	int numFrames = 0;
+};
+
+// a frame of a sheet on its way into the atlas
+struct AtlasEntry {
+	SDL_Surface *sheet;
+	SDL_Rect source;
+	SDL_Rect *dest;
+};
+
+// copies source to dest, then stretches its outermost rows, columns and corner pixels over the padding
+inline void blitExtruded(SDL_Surface *sheet, SDL_Rect source, SDL_Surface *atlasSurface, int x, int y) {
+	SDL_Rect dest = {x, y, source.w, source.h};
+	SDL_BlitSurface(sheet, &source, atlasSurface, &dest);
+
+	int right = source.x + source.w - 1;
+	int bottom = source.y + source.h - 1;
+	const int pad = AtlasPadding;
+	SDL_Rect copies[8][2] = {
+		// edges
+		{{source.x, source.y, source.w, 1}, {x, y - pad, source.w, pad}},
+		{{source.x, bottom, source.w, 1}, {x, y + source.h, source.w, pad}},
+		{{source.x, source.y, 1, source.h}, {x - pad, y, pad, source.h}},
+		{{right, source.y, 1, source.h}, {x + source.w, y, pad, source.h}},
+		// corners
+		{{source.x, source.y, 1, 1}, {x - pad, y - pad, pad, pad}},
+		{{right, source.y, 1, 1}, {x + source.w, y - pad, pad, pad}},
+		{{source.x, bottom, 1, 1}, {x - pad, y + source.h, pad, pad}},
+		{{right, bottom, 1, 1}, {x + source.w, y + source.h, pad, pad}}
+	};
+	for(int i = 0; i < 8; i++) {
+		SDL_BlitScaled(sheet, &copies[i][0], atlasSurface, &copies[i][1]);
+	}
+}
+
+// loads the sheets, packs them into shelves and uploads the atlas
+// keeps the packed surface in surfaceOut when it isn't NULL, for baking into other surfaces, the caller frees it
+inline bool initSpriteAtlas(SpriteAtlas &atlas, SDL_Renderer *renderer, int tilePixels, SDL_Surface **surfaceOut) {
+	SDL_Surface *sheets[NumSpriteSheets] = {};
+	bool loaded = true;
+	for(int i = 0; i < NumSpriteSheets; i++) {
+		sheets[i] = IMG_Load(SpriteSheetFiles[i]);
+		if(sheets[i] == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load %s: %s", SpriteSheetFiles[i], IMG_GetError());
+			loaded = false;
+		} else {
+			// copy alpha as is, blending onto the empty atlas would lose it
+			SDL_SetSurfaceBlendMode(sheets[i], SDL_BLENDMODE_NONE);
+		}
+	}
+
+	AtlasEntry entries[MaxAtlasTiles + MaxSpriteFrames];
+	int numEntries = 0;
+	atlas.tilePixels = tilePixels;
+	atlas.tilesPerRow = atlas.tilesPerColumn = 0;
+	if(sheets[SheetTiles] != NULL) {
+		atlas.tilesPerRow = sheets[SheetTiles]->w / tilePixels;
+		atlas.tilesPerColumn = sheets[SheetTiles]->h / tilePixels;
+		if(atlas.tilesPerRow*atlas.tilesPerColumn > MaxAtlasTiles) {
+			atlas.tilesPerColumn = MaxAtlasTiles / atlas.tilesPerRow;
+		}
+	}
+	for(int i = 0; i < atlas.tilesPerRow*atlas.tilesPerColumn; i++) {
+		AtlasEntry &entry = entries[numEntries++];
+		entry.sheet = sheets[SheetTiles];
+		entry.source.x = (i % atlas.tilesPerRow) * tilePixels;
+		entry.source.y = (i / atlas.tilesPerRow) * tilePixels;
+		entry.source.w = entry.source.h = tilePixels;
+		entry.dest = &atlas.tiles[i];
+	}
+
+	atlas.numFrames = 0;
+	for(int sprite = 0; sprite < NumSprites; sprite++) {
+		const SpriteRegion &region = SpriteRegions[sprite];
+		atlas.firstFrame[sprite] = atlas.numFrames;
+		for(int frame = 0; frame < region.numFrames; frame++) {
+			SDL_Rect &dest = atlas.frames[atlas.numFrames++];
+			dest.x = dest.y = 0;
+			dest.w = region.w;
+			dest.h = region.h;
+			if(sheets[region.sheet] == NULL) {
+				continue;
+			}
+			AtlasEntry &entry = entries[numEntries++];
+			entry.sheet = sheets[region.sheet];
+			entry.source.x = region.x + frame*region.stepX;
+			entry.source.y = region.y + frame*region.stepY;
+			entry.source.w = region.w;
+			entry.source.h = region.h;
+			entry.dest = &dest;
+		}
+	}
+
+	// shelves, tallest frames first so each shelf wastes little height
+	// insertion sort, the entries are few and already grouped by size
+	for(int i = 1; i < numEntries; i++) {
+		AtlasEntry entry = entries[i];
+		int j = i;
+		for(; j > 0 && entries[j - 1].source.h < entry.source.h; j--) {
+			entries[j] = entries[j - 1];
+		}
+		entries[j] = entry;
+	}
+	int shelfX = 0;
+	int shelfY = 0;
+	int shelfHeight = 0;
+	for(int i = 0; i < numEntries; i++) {
+		AtlasEntry &entry = entries[i];
+		int paddedWidth = entry.source.w + 2*AtlasPadding;
+		int paddedHeight = entry.source.h + 2*AtlasPadding;
+		if(shelfX + paddedWidth > AtlasWidth) {
+			shelfX = 0;
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+		}
+		entry.dest->x = shelfX + AtlasPadding;
+		entry.dest->y = shelfY + AtlasPadding;
+		entry.dest->w = entry.source.w;
+		entry.dest->h = entry.source.h;
+		shelfX += paddedWidth;
+		shelfHeight = (paddedHeight > shelfHeight) ? paddedHeight : shelfHeight;
+	}
+	atlas.width = AtlasWidth;
+	atlas.height = 1;
+	while(atlas.height < shelfY + shelfHeight) {
+		atlas.height *= 2;
+	}
+
+	SDL_Surface *atlasSurface = SDL_CreateRGBSurface(
+		0, atlas.width, atlas.height,
+		32, 0xFF000000, 0x00FF0000, 0X0000FF00, 0X000000FF);
+	for(int i = 0; i < numEntries && atlasSurface != NULL; i++) {
+		blitExtruded(entries[i].sheet, entries[i].source, atlasSurface, entries[i].dest->x, entries[i].dest->y);
+	}
+	for(int i = 0; i < NumSpriteSheets; i++) {
+		SDL_FreeSurface(sheets[i]);
+	}
+	if(atlasSurface == NULL) {
+		return false;
+	}
+
+	atlas.texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+	if(surfaceOut != NULL) {
+		*surfaceOut = atlasSurface;
+	} else {
+		SDL_FreeSurface(atlasSurface);
+	}
+	return loaded && atlas.texture != NULL;
+}
+
+inline void freeSpriteAtlas(SpriteAtlas &atlas) {
+	SDL_DestroyTexture(atlas.texture);
+	atlas.texture = NULL;
+}
+
+// the atlas rect of the tileset tile at (sourceX, sourceY) in tiles.png, like LevelQuad's source
+inline SDL_Rect atlasTile(SpriteAtlas &atlas, int sourceX, int sourceY) {
+	int column = sourceX / atlas.tilePixels;
+	int row = sourceY / atlas.tilePixels;
+	if(column >= atlas.tilesPerRow || row >= atlas.tilesPerColumn) {
+		SDL_Rect empty = {0, 0, 0, 0};
+		return empty;
+	}
+	return atlas.tiles[row*atlas.tilesPerRow + column];
+}
+
+// frames loop, so an animation can pass a running frame count
+inline SDL_Rect &spriteFrame(SpriteAtlas &atlas, SpriteId sprite, int frame) {
+	int numFrames = SpriteRegions[sprite].numFrames;
+	return atlas.frames[atlas.firstFrame[sprite] + ((frame % numFrames) + numFrames) % numFrames];
+}
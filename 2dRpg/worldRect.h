@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+
+// world positions and sizes
+// fixed point by default: whole units of 1/WorldUnitsPerMeter meters, so the collision tests below are
+// exact integer compares that come out the same on every compiler and optimization level
+// build with WORLD_FLOAT_COORDS to go back to float meters
+
+#ifdef WORLD_FLOAT_COORDS
+typedef float WorldCoord;
+
+inline WorldCoord toWorld(float meters) {
+	return meters;
+}
+
+inline float toMeters(WorldCoord coord) {
+	return coord;
+}
+#else
+typedef int32_t WorldCoord;
+
+// 16.16, about 0.015mm per unit and +-32km of world
+const int WorldFixedShift = 16;
+const int32_t WorldUnitsPerMeter = 1 << WorldFixedShift;
+
+// rounds to the nearest unit, halves up
+// a float times a power of two plus 0.5 is exact in a double, so flooring that is the only rounding step
+// the floor is a truncation fixed up for negatives, floor() itself is slow enough to show in the soak test
+// out of range meters saturate, NaN gives the lowest coordinate
+inline WorldCoord toWorld(float meters) {
+	double units = (double)meters * WorldUnitsPerMeter + 0.5;
+	if(!(units >= -2147483648.0)) {
+		return INT32_MIN;
+	}
+	if(units >= 2147483647.0) {
+		return INT32_MAX;
+	}
+	WorldCoord coord = (WorldCoord)units;
+	return (units < coord) ? coord - 1 : coord;
+}
+
+inline float toMeters(WorldCoord coord) {
+	return (float)coord * (1.0f / WorldUnitsPerMeter);
+}
+#endif
+
+struct WorldRect {
+	WorldCoord x;
+	WorldCoord y;
+	WorldCoord w;
+	WorldCoord h;
+};
+
+inline WorldRect worldRectFromMeters(float x, float y, float w, float h) {
+	WorldRect rect = {toWorld(x), toWorld(y), toWorld(w), toWorld(h)};
+	return rect;
+}
+
+inline bool xOverlap(WorldRect &a, WorldRect &b) {
+	return a.x + a.w > b.x && a.x < b.x + b.w;
+}
+
+inline bool yOverlap(WorldRect &a, WorldRect &b) {
+	return a.y + a.h > b.y && a.y < b.y + b.h;
+}
+
+inline bool standingOn(WorldRect &a, WorldRect &b) {
+	return a.y == b.y + b.h;
+}
+
+inline bool isAbove(WorldRect &a, WorldRect &b) {
+	return a.y >= b.y + b.h;
+}
+
+inline bool isBelowBottom(WorldRect &a, WorldRect &b) {
+	return a.y < b.y;
+}
+
+inline bool isBelowTop(WorldRect &a, WorldRect &b) {
+	return a.y < b.y + b.h;
+}
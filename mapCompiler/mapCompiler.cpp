@@ -0,0 +1,679 @@
+// mapCompiler
+// compiles TileMap.txt / .csv / .tmx maps into the binary level format of levelFormat.h
+//
+// usage: mapCompiler <input.txt|input.csv|input.tmx> <output.lvl> [chunkSize]
+//        mapCompiler -generate <width> <height> <seed> <output.lvl|output.txt> [threads] [chunkSize]
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../2dRpg/levelFormat.h"
+#include "../2dRpg/levelGen.h"
+
+const int TilePixels = 16;
+const int TilesetColumns = 8;  // tiles.png is 8x5 tiles
+const int DefaultChunkSize = 16;
+const long long MaxLevelTiles = 1 << 28;  // keeps the compiled level well inside its 32 bit offsets
+
+// collision type of every tile in tiles.png, used for tileset based maps (csv, tmx)
+const uint8_t TilesetTypes[] = {
+	1, 1, 1, 1, 0, 0, 1, 1,
+	0, 0, 0, 0, 0, 1, 1, 1,
+	0, 0, 0, 0, 1, 1, 1, 1,
+	1, 1, 1, 1, 0, 0, 0, 1,
+	1, 1, 1, 1, 0, 0, 0, 1,
+};
+const int NumTilesetTiles = sizeof(TilesetTypes) / sizeof(TilesetTypes[0]);
+
+uint8_t tilesetType(int graphic) {
+	if(graphic < 0 || graphic >= NumTilesetTiles) {
+		return TileNone;
+	}
+	return TilesetTypes[graphic];
+}
+
+bool validLevelSize(int width, int height) {
+	return width > 0 && height > 0 && width <= 0xFFFF && height <= 0xFFFF && (long long)width*height <= MaxLevelTiles;
+}
+
+// quads store their dest relative to the chunk in 16 bits
+bool validChunkSize(int chunkSize) {
+	return chunkSize > 0 && chunkSize <= 0xFFFF / TilePixels;
+}
+
+bool endsWith(const std::string &str, const char *suffix) {
+	size_t len = strlen(suffix);
+	if(str.length() < len) {
+		return false;
+	}
+	for(size_t i = 0; i < len; i++) {
+		if(tolower(str[str.length() - len + i]) != suffix[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool readFile(const char *filename, std::string &out) {
+	std::ifstream file(filename, std::ios::binary);
+	if(!file.is_open()) {
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	out = buffer.str();
+	return true;
+}
+
+void splitLines(const std::string &text, std::vector<std::string> &lines) {
+	std::string line;
+	std::istringstream stream(text);
+	while(getline(stream, line)) {
+		if(!line.empty() && line[line.length() - 1] == '\r') {
+			line.erase(line.length() - 1);
+		}
+		lines.push_back(line);
+	}
+	while(!lines.empty() && lines.back().empty()) {
+		lines.pop_back();
+	}
+}
+
+void initSource(LevelSource &src, int width, int height, int numLayers) {
+	src.width = width;
+	src.height = height;
+	src.types.assign(width*height, TileNone);
+	src.layers.assign(numLayers, std::vector<uint16_t>(width*height, LevelNoGraphic));
+}
+
+// TileMap.txt: one digit (TileType) per tile, top row first
+// the tile graphic is the tileset tile with the same index as the type
+bool readText(const std::string &text, LevelSource &src) {
+	std::vector<std::string> lines;
+	splitLines(text, lines);
+	size_t width = 0;
+	for(size_t i = 0; i < lines.size(); i++) {
+		width = lines[i].length() > width ? lines[i].length() : width;
+	}
+	if(width == 0) {
+		fprintf(stderr, "map is empty\n");
+		return false;
+	}
+
+	initSource(src, (int)width, (int)lines.size(), 1);
+	for(int row = 0; row < src.height; row++) {
+		int y = (src.height - 1) - row;
+		for(int x = 0; x < src.width; x++) {
+			int type = TileNone;
+			if(x < (int)lines[row].length()) {
+				type = lines[row][x] - '0';
+				if(type < 0 || type >= TileNumElements) {
+					fprintf(stderr, "warning: unknown tile '%c' at (%d,%d)\n", lines[row][x], x, row);
+					type = TileNone;
+				}
+			}
+			src.types[y*src.width + x] = (uint8_t)type;
+			src.layers[0][y*src.width + x] = (uint16_t)type;
+		}
+	}
+	return true;
+}
+
+// parses comma separated tile indices, -1 (or 0 with gids) is an empty tile
+void readCsvValues(const std::string &text, std::vector<long> &values) {
+	const char *at = text.c_str();
+	while(*at) {
+		char *end;
+		long value = strtol(at, &end, 10);
+		if(end == at) {
+			at++;
+		} else {
+			values.push_back(value);
+			at = end;
+		}
+	}
+}
+
+// tileMap.csv: one tileset index per tile, top row first
+bool readCsv(const std::string &text, LevelSource &src) {
+	std::vector<std::string> lines;
+	splitLines(text, lines);
+	std::vector<std::vector<long> > rows(lines.size());
+	size_t width = 0;
+	for(size_t i = 0; i < lines.size(); i++) {
+		readCsvValues(lines[i], rows[i]);
+		width = rows[i].size() > width ? rows[i].size() : width;
+	}
+	if(width == 0) {
+		fprintf(stderr, "map is empty\n");
+		return false;
+	}
+
+	initSource(src, (int)width, (int)rows.size(), 1);
+	for(int row = 0; row < src.height; row++) {
+		int y = (src.height - 1) - row;
+		for(int x = 0; x < (int)rows[row].size(); x++) {
+			long graphic = rows[row][x];
+			if(graphic >= 0 && graphic < LevelNoGraphic) {
+				src.types[y*src.width + x] = tilesetType((int)graphic);
+				src.layers[0][y*src.width + x] = (uint16_t)graphic;
+			}
+		}
+	}
+	return true;
+}
+
+// base64 and zlib, for tmx layer data
+
+bool decodeBase64(const std::string &text, std::vector<uint8_t> &out) {
+	uint32_t bits = 0;
+	int numBits = 0;
+	for(size_t i = 0; i < text.length(); i++) {
+		char c = text[i];
+		int value;
+		if(c >= 'A' && c <= 'Z') value = c - 'A';
+		else if(c >= 'a' && c <= 'z') value = c - 'a' + 26;
+		else if(c >= '0' && c <= '9') value = c - '0' + 52;
+		else if(c == '+') value = 62;
+		else if(c == '/') value = 63;
+		else if(c == '=') break;
+		else if(isspace((unsigned char)c)) continue;
+		else return false;
+
+		bits = (bits << 6) | value;
+		numBits += 6;
+		if(numBits >= 8) {
+			numBits -= 8;
+			out.push_back((uint8_t)(bits >> numBits));
+		}
+	}
+	return true;
+}
+
+struct BitReader {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+	uint32_t bitBuffer;
+	int bitCount;
+	bool failed;
+};
+
+int getBits(BitReader &in, int count) {
+	while(in.bitCount < count) {
+		if(in.pos >= in.size) {
+			in.failed = true;
+			return 0;
+		}
+		in.bitBuffer |= (uint32_t)in.data[in.pos++] << in.bitCount;
+		in.bitCount += 8;
+	}
+	int value = (int)(in.bitBuffer & ((1u << count) - 1));
+	in.bitBuffer >>= count;
+	in.bitCount -= count;
+	return value;
+}
+
+// canonical huffman table, decoded one bit at a time
+struct Huffman {
+	uint16_t counts[16];
+	uint16_t symbols[288];
+};
+
+void buildHuffman(Huffman &h, const uint8_t *lengths, int numSymbols) {
+	uint16_t offsets[16];
+	memset(h.counts, 0, sizeof(h.counts));
+	for(int i = 0; i < numSymbols; i++) {
+		h.counts[lengths[i]]++;
+	}
+	h.counts[0] = 0;
+	offsets[1] = 0;
+	for(int len = 1; len < 15; len++) {
+		offsets[len + 1] = offsets[len] + h.counts[len];
+	}
+	for(int i = 0; i < numSymbols; i++) {
+		if(lengths[i] != 0) {
+			h.symbols[offsets[lengths[i]]++] = (uint16_t)i;
+		}
+	}
+}
+
+int decodeSymbol(BitReader &in, Huffman &h) {
+	int code = 0;
+	int first = 0;
+	int index = 0;
+	for(int len = 1; len < 16; len++) {
+		code |= getBits(in, 1);
+		int count = h.counts[len];
+		if(code - count < first) {
+			return h.symbols[index + (code - first)];
+		}
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+	in.failed = true;
+	return 0;
+}
+
+const uint16_t LengthBase[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t LengthExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DistBase[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t DistExtra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+const uint8_t CodeLengthOrder[] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+bool inflateBlock(BitReader &in, Huffman &lengths, Huffman &dists, std::vector<uint8_t> &out) {
+	for(;;) {
+		int symbol = decodeSymbol(in, lengths);
+		if(in.failed) {
+			return false;
+		}
+		if(symbol < 256) {
+			out.push_back((uint8_t)symbol);
+		} else if(symbol == 256) {
+			return true;
+		} else {
+			symbol -= 257;
+			if(symbol >= 29) {
+				return false;
+			}
+			int length = LengthBase[symbol] + getBits(in, LengthExtra[symbol]);
+			int distSymbol = decodeSymbol(in, dists);
+			if(distSymbol >= 30) {
+				return false;
+			}
+			size_t dist = DistBase[distSymbol] + getBits(in, DistExtra[distSymbol]);
+			if(in.failed || dist > out.size()) {
+				return false;
+			}
+			for(int i = 0; i < length; i++) {
+				out.push_back(out[out.size() - dist]);
+			}
+		}
+	}
+}
+
+bool inflateZlib(const std::vector<uint8_t> &data, std::vector<uint8_t> &out) {
+	if(data.size() < 6 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) {
+		return false;
+	}
+	BitReader in = {&data[0], data.size() - 4, 2, 0, 0, false};
+
+	int isLast;
+	do {
+		isLast = getBits(in, 1);
+		int blockType = getBits(in, 2);
+		if(blockType == 0) {
+			// stored
+			in.bitBuffer = 0;
+			in.bitCount = 0;
+			if(in.pos + 4 > in.size) {
+				return false;
+			}
+			int len = data[in.pos] | (data[in.pos + 1] << 8);
+			in.pos += 4;
+			if(in.pos + len > in.size) {
+				return false;
+			}
+			out.insert(out.end(), data.begin() + in.pos, data.begin() + in.pos + len);
+			in.pos += len;
+		} else if(blockType == 1 || blockType == 2) {
+			uint8_t codeLengths[288 + 32];
+			int numLengths = 288;
+			int numDists = 30;
+			if(blockType == 1) {
+				// fixed
+				int i = 0;
+				for(; i < 144; i++) codeLengths[i] = 8;
+				for(; i < 256; i++) codeLengths[i] = 9;
+				for(; i < 280; i++) codeLengths[i] = 7;
+				for(; i < 288; i++) codeLengths[i] = 8;
+				for(; i < 288 + 30; i++) codeLengths[i] = 5;
+			} else {
+				// dynamic
+				numLengths = getBits(in, 5) + 257;
+				numDists = getBits(in, 5) + 1;
+				int numCodes = getBits(in, 4) + 4;
+				uint8_t lengthLengths[19] = {};
+				for(int i = 0; i < numCodes; i++) {
+					lengthLengths[CodeLengthOrder[i]] = (uint8_t)getBits(in, 3);
+				}
+				Huffman lengthCodes;
+				buildHuffman(lengthCodes, lengthLengths, 19);
+				int i = 0;
+				while(i < numLengths + numDists && !in.failed) {
+					int symbol = decodeSymbol(in, lengthCodes);
+					int repeat = 0;
+					uint8_t value = 0;
+					if(symbol < 16) {
+						codeLengths[i++] = (uint8_t)symbol;
+						continue;
+					} else if(symbol == 16) {
+						if(i == 0) {
+							return false;
+						}
+						value = codeLengths[i - 1];
+						repeat = 3 + getBits(in, 2);
+					} else if(symbol == 17) {
+						repeat = 3 + getBits(in, 3);
+					} else {
+						repeat = 11 + getBits(in, 7);
+					}
+					if(i + repeat > numLengths + numDists) {
+						return false;
+					}
+					while(repeat--) {
+						codeLengths[i++] = value;
+					}
+				}
+			}
+			Huffman lengths;
+			Huffman dists;
+			buildHuffman(lengths, codeLengths, numLengths);
+			buildHuffman(dists, codeLengths + numLengths, numDists);
+			if(in.failed || !inflateBlock(in, lengths, dists, out)) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	} while(!isLast);
+
+	// adler32 trailer
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for(size_t i = 0; i < out.size(); i++) {
+		a = (a + out[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	size_t end = data.size() - 4;
+	uint32_t adler = ((uint32_t)data[end] << 24) | (data[end + 1] << 16) | (data[end + 2] << 8) | data[end + 3];
+	return adler == ((b << 16) | a);
+}
+
+// minimal xml helpers, enough for the files Tiled writes
+
+bool findTag(const std::string &text, const char *name, size_t from, size_t &tagBegin, size_t &tagEnd) {
+	std::string open = std::string("<") + name;
+	size_t at = from;
+	for(;;) {
+		at = text.find(open, at);
+		if(at == std::string::npos) {
+			return false;
+		}
+		char next = text[at + open.length()];
+		if(isspace((unsigned char)next) || next == '>' || next == '/') {
+			break;
+		}
+		at += open.length();
+	}
+	tagBegin = at;
+	tagEnd = text.find('>', at);
+	return tagEnd != std::string::npos;
+}
+
+std::string getAttribute(const std::string &text, size_t tagBegin, size_t tagEnd, const char *name) {
+	std::string key = std::string(" ") + name + "=\"";
+	size_t at = text.find(key, tagBegin);
+	if(at == std::string::npos || at > tagEnd) {
+		return "";
+	}
+	at += key.length();
+	size_t end = text.find('"', at);
+	return text.substr(at, end - at);
+}
+
+// tileMap.tmx: one tileset, any number of layers (csv, base64 or base64+zlib)
+// tiles are solid if any layer has a solid tile there
+bool readTmx(const std::string &text, LevelSource &src) {
+	size_t tagBegin, tagEnd;
+	if(!findTag(text, "map", 0, tagBegin, tagEnd)) {
+		fprintf(stderr, "no <map> element\n");
+		return false;
+	}
+	int width = atoi(getAttribute(text, tagBegin, tagEnd, "width").c_str());
+	int height = atoi(getAttribute(text, tagBegin, tagEnd, "height").c_str());
+	if(width <= 0 || height <= 0) {
+		fprintf(stderr, "bad map size %dx%d\n", width, height);
+		return false;
+	}
+
+	uint32_t firstGid = 1;
+	if(findTag(text, "tileset", tagEnd, tagBegin, tagEnd)) {
+		firstGid = (uint32_t)atoi(getAttribute(text, tagBegin, tagEnd, "firstgid").c_str());
+	}
+
+	std::vector<std::vector<uint32_t> > layers;
+	size_t at = 0;
+	while(findTag(text, "layer", at, tagBegin, tagEnd)) {
+		if(!findTag(text, "data", tagEnd, tagBegin, tagEnd)) {
+			fprintf(stderr, "layer without data\n");
+			return false;
+		}
+		std::string encoding = getAttribute(text, tagBegin, tagEnd, "encoding");
+		std::string compression = getAttribute(text, tagBegin, tagEnd, "compression");
+		size_t dataEnd = text.find("</data>", tagEnd);
+		if(dataEnd == std::string::npos) {
+			fprintf(stderr, "unterminated <data>\n");
+			return false;
+		}
+		std::string content = text.substr(tagEnd + 1, dataEnd - tagEnd - 1);
+
+		std::vector<uint32_t> gids;
+		if(encoding == "csv") {
+			std::vector<long> values;
+			readCsvValues(content, values);
+			gids.assign(values.begin(), values.end());
+		} else if(encoding == "base64") {
+			std::vector<uint8_t> bytes;
+			if(!decodeBase64(content, bytes)) {
+				fprintf(stderr, "bad base64 layer data\n");
+				return false;
+			}
+			if(compression == "zlib") {
+				std::vector<uint8_t> inflated;
+				if(!inflateZlib(bytes, inflated)) {
+					fprintf(stderr, "bad zlib layer data\n");
+					return false;
+				}
+				bytes.swap(inflated);
+			} else if(!compression.empty()) {
+				fprintf(stderr, "unsupported layer compression '%s'\n", compression.c_str());
+				return false;
+			}
+			for(size_t i = 0; i + 3 < bytes.size(); i += 4) {
+				gids.push_back(bytes[i] | (bytes[i + 1] << 8) | (bytes[i + 2] << 16) | ((uint32_t)bytes[i + 3] << 24));
+			}
+		} else {
+			size_t tileAt = tagEnd;
+			while(findTag(text, "tile", tileAt, tagBegin, tagEnd) && tagBegin < dataEnd) {
+				gids.push_back((uint32_t)strtoul(getAttribute(text, tagBegin, tagEnd, "gid").c_str(), NULL, 10));
+				tileAt = tagEnd;
+			}
+		}
+
+		if(gids.size() != (size_t)(width*height)) {
+			fprintf(stderr, "layer has %d tiles, expected %d\n", (int)gids.size(), width*height);
+			return false;
+		}
+		layers.push_back(gids);
+		at = dataEnd;
+	}
+
+	initSource(src, width, height, (int)layers.size());
+	for(size_t layer = 0; layer < layers.size(); layer++) {
+		for(int row = 0; row < height; row++) {
+			int y = (height - 1) - row;
+			for(int x = 0; x < width; x++) {
+				uint32_t gid = layers[layer][row*width + x] & 0x1FFFFFFF; // drop flip flags
+				if(gid < firstGid) {
+					continue;
+				}
+				int graphic = (int)(gid - firstGid);
+				src.layers[layer][y*width + x] = (uint16_t)graphic;
+				uint8_t type = tilesetType(graphic);
+				if(type > src.types[y*width + x]) {
+					src.types[y*width + x] = type;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// platforms and ladders, a map with none has nothing to collide with
+int countSolidTiles(const LevelSource &src) {
+	int numSolid = 0;
+	for(size_t i = 0; i < src.types.size(); i++) {
+		numSolid += (src.types[i] != TileNone) ? 1 : 0;
+	}
+	return numSolid;
+}
+
+bool writeFile(const char *filename, const void *data, size_t size) {
+	FILE *file = fopen(filename, "wb");
+	if(file == NULL) {
+		return false;
+	}
+	size_t written = fwrite(data, 1, size, file);
+	fclose(file);
+	return written == size;
+}
+
+// the inverse of readText, top row first
+void writeText(LevelSource &src, std::string &out) {
+	out.clear();
+	out.reserve((src.width + 1)*src.height);
+	for(int y = src.height - 1; y >= 0; y--) {
+		for(int x = 0; x < src.width; x++) {
+			out += (char)('0' + src.types[y*src.width + x]);
+		}
+		out += '\n';
+	}
+}
+
+int generate(int argc, char *argv[]) {
+	if(argc < 6) {
+		fprintf(stderr, "usage: mapCompiler -generate <width> <height> <seed> <output.lvl|output.txt> [threads] [chunkSize]\n");
+		return 1;
+	}
+	int width = atoi(argv[2]);
+	int height = atoi(argv[3]);
+	uint32_t seed = (uint32_t)strtoul(argv[4], NULL, 10);
+	std::string outputName = argv[5];
+	int numThreads = (argc > 6) ? atoi(argv[6]) : (int)std::thread::hardware_concurrency();
+	int chunkSize = (argc > 7) ? atoi(argv[7]) : DefaultChunkSize;
+	if(!validLevelSize(width, height)) {
+		fprintf(stderr, "bad map size %dx%d\n", width, height);
+		return 1;
+	}
+	if(!levelGenFitsBand(height)) {
+		fprintf(stderr, "a %d row map has no room for a band of platforms\n", height);
+		return 1;
+	}
+	if(!validChunkSize(chunkSize)) {
+		fprintf(stderr, "bad chunk size %d, 1 to %d\n", chunkSize, 0xFFFF / TilePixels);
+		return 1;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	LevelSource src;
+	generateLevel(src, width, height, seed, numThreads);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// every run can still be dropped (too narrow a strip, no room for its ladder), so an empty map
+	// would pass the reachability check without checking anything
+	if(countSolidTiles(src) == 0) {
+		fprintf(stderr, "generated map has no platforms\n");
+		return 1;
+	}
+	int numUnreachable = countUnreachableSurfaces(src);
+	if(numUnreachable != 0) {
+		fprintf(stderr, "generated map has %d unreachable tiles\n", numUnreachable);
+		return 1;
+	}
+
+	bool ok;
+	size_t size;
+	if(endsWith(outputName, ".txt")) {
+		std::string text;
+		writeText(src, text);
+		ok = writeFile(outputName.c_str(), text.data(), text.size());
+		size = text.size();
+	} else {
+		std::vector<uint8_t> level = buildLevel(src, chunkSize, TilePixels, TilesetColumns);
+		ok = writeFile(outputName.c_str(), &level[0], level.size());
+		size = level.size();
+	}
+	if(!ok) {
+		fprintf(stderr, "failed to write %s\n", outputName.c_str());
+		return 1;
+	}
+
+	printf("seed %u -> %s: %dx%d tiles generated in %.1f ms, %d bytes\n",
+		seed, outputName.c_str(), width, height, ms, (int)size);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	if(argc > 1 && strcmp(argv[1], "-generate") == 0) {
+		return generate(argc, argv);
+	}
+	if(argc < 3) {
+		fprintf(stderr, "usage: mapCompiler <input.txt|input.csv|input.tmx> <output.lvl> [chunkSize]\n");
+		fprintf(stderr, "       mapCompiler -generate <width> <height> <seed> <output.lvl|output.txt> [threads] [chunkSize]\n");
+		return 1;
+	}
+	std::string inputName = argv[1];
+	const char *outputName = argv[2];
+	int chunkSize = (argc > 3) ? atoi(argv[3]) : DefaultChunkSize;
+	if(!validChunkSize(chunkSize)) {
+		fprintf(stderr, "bad chunk size %d, 1 to %d\n", chunkSize, 0xFFFF / TilePixels);
+		return 1;
+	}
+
+	std::string text;
+	if(!readFile(inputName.c_str(), text)) {
+		fprintf(stderr, "can't open %s\n", inputName.c_str());
+		return 1;
+	}
+
+	LevelSource src;
+	bool ok;
+	if(endsWith(inputName, ".tmx")) {
+		ok = readTmx(text, src);
+	} else if(endsWith(inputName, ".csv")) {
+		ok = readCsv(text, src);
+	} else {
+		ok = readText(text, src);
+	}
+	if(!ok) {
+		fprintf(stderr, "failed to read %s\n", inputName.c_str());
+		return 1;
+	}
+	if(!validLevelSize(src.width, src.height)) {
+		fprintf(stderr, "bad map size %dx%d\n", src.width, src.height);
+		return 1;
+	}
+
+	// still compiled, but a map drawn only with background tiles (or with TilesetTypes wrong) shouldn't pass unnoticed
+	if(countSolidTiles(src) == 0) {
+		fprintf(stderr, "%s: warning: no platforms or ladders, the level has nothing to collide with\n", inputName.c_str());
+	}
+
+	std::vector<uint8_t> level = buildLevel(src, chunkSize, TilePixels, TilesetColumns);
+
+	if(!writeFile(outputName, &level[0], level.size())) {
+		fprintf(stderr, "failed to write %s\n", outputName);
+		return 1;
+	}
+
+	printf("%s -> %s: %dx%d tiles, %d bytes\n", inputName.c_str(), outputName, src.width, src.height, (int)level.size());
+	return 0;
+}